@@ -1,4 +1,5 @@
-import { ChildProcess, spawn } from 'child_process';
+import { ChildProcessWithoutNullStreams, spawn } from 'child_process';
+import readline from 'readline';
 import { MemoryFifo } from 'setup-mpc-common';
 import { Address } from 'web3x/address';
 import { TranscriptStore } from './transcript-store';
@@ -12,7 +13,9 @@ export class Verifier {
   private queue: MemoryFifo<VerifyItem> = new MemoryFifo();
   public lastCompleteAddress?: Address;
   public runningAddress?: Address;
-  private proc?: ChildProcess;
+  private proc?: ChildProcessWithoutNullStreams;
+  private pending = new Map<string, (verified: boolean) => void>();
+  private nextRequestId = 0;
   private cancelled = false;
 
   constructor(
@@ -24,7 +27,7 @@ export class Verifier {
   ) {}
 
   public async active() {
-    return this.proc || (await this.queue.length());
+    return this.pending.size || (await this.queue.length());
   }
 
   public async run() {
@@ -62,6 +65,9 @@ export class Verifier {
         console.log(err);
       }
     }
+    if (this.proc) {
+      this.proc.stdin.end();
+    }
     console.log('Verifier completed.');
   }
 
@@ -105,23 +111,53 @@ export class Verifier {
     }
 
     console.log(`Verifiying transcript ${transcriptNumber}...`);
+    const proc = this.proc || this.startDaemon();
+    const requestId = (this.nextRequestId++).toString();
     return new Promise<boolean>(resolve => {
-      const binPath = '../setup-tools/verify';
-      const verify = spawn(binPath, args);
-      this.proc = verify;
-
-      verify.stdout.on('data', data => {
-        console.log(data.toString());
-      });
-
-      verify.stderr.on('data', data => {
-        console.log(data.toString());
-      });
-
-      verify.on('close', code => {
-        this.proc = undefined;
-        resolve(code === 0);
-      });
+      this.pending.set(requestId, resolve);
+      proc.stdin.write(`verify ${requestId} ${args.join(' ')}\n`);
     });
   }
+
+  // A single verify process is kept running, and takes one command per line on stdin. It is restarted if it exits.
+  private startDaemon() {
+    const binPath = '../setup-tools/verify';
+    const verify = spawn(binPath, ['--daemon', '--staged']);
+    this.proc = verify;
+
+    readline
+      .createInterface({
+        input: verify.stdout,
+        terminal: false,
+      })
+      .on('line', this.handleVerifyOutput);
+
+    verify.stderr.on('data', data => {
+      console.log(data.toString());
+    });
+
+    verify.on('close', () => {
+      this.proc = undefined;
+      // Requests still outstanding can no longer be answered.
+      this.pending.forEach(resolve => resolve(false));
+      this.pending.clear();
+    });
+
+    return verify;
+  }
+
+  // Responses take the form "<request id> valid", or "<request id> invalid <reason>".
+  private handleVerifyOutput = (line: string) => {
+    const [requestId, result] = line.split(' ');
+    const resolve = this.pending.get(requestId);
+    if (!resolve) {
+      console.log(`Unexpected output from verify: ${line}`);
+      return;
+    }
+    if (result !== 'valid') {
+      console.log(line);
+    }
+    this.pending.delete(requestId);
+    resolve(result === 'valid');
+  };
 }
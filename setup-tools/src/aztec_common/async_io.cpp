@@ -0,0 +1,567 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "async_io.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#define HAS_IO_URING 1
+#endif
+
+namespace streaming
+{
+
+namespace
+{
+
+constexpr size_t BUFFER_ALIGNMENT = 4096;
+
+void close_all(std::vector<int> const &fds)
+{
+    for (size_t i = 0; i < fds.size(); ++i)
+    {
+        if (fds[i] != -1)
+        {
+            close(fds[i]);
+        }
+    }
+}
+
+void transfer_fully(int fd, bool write, char *buffer, size_t size, size_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t result = write ? pwrite(fd, buffer, size, offset) : pread(fd, buffer, size, offset);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result < 0)
+        {
+            throw std::runtime_error(std::string(write ? "Write" : "Read") + " failed: " + strerror(errno));
+        }
+        if (result == 0)
+        {
+            throw std::runtime_error(write ? "Write failed: no space left." : "Read failed: unexpected end of file.");
+        }
+        buffer += result;
+        size -= result;
+        offset += result;
+    }
+}
+
+// Fallback backend. A pool of threads, one per queue slot, each issuing blocking preads and pwrites.
+class ThreadPoolIo : public AsyncIo
+{
+  public:
+    ThreadPoolIo(size_t queue_depth, size_t buffer_size)
+        : AsyncIo(queue_depth, buffer_size)
+        , stopping_(false)
+    {
+        for (size_t i = 0; i < queue_depth; ++i)
+        {
+            workers_.push_back(std::thread(&ThreadPoolIo::work, this));
+        }
+    }
+
+    ~ThreadPoolIo()
+    {
+        drain();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        submitted_cv_.notify_all();
+        for (size_t i = 0; i < workers_.size(); ++i)
+        {
+            workers_[i].join();
+        }
+    }
+
+    char const *name() const override { return "threads"; }
+
+  protected:
+    void submit(Operation const &op) override
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            submitted_.push_back(op);
+        }
+        submitted_cv_.notify_one();
+    }
+
+    size_t wait(std::string &error) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        completed_cv_.wait(lock, [this] { return !completed_.empty(); });
+        Completion completion = completed_.front();
+        completed_.pop_front();
+        error = completion.error;
+        return completion.buffer;
+    }
+
+  private:
+    struct Completion
+    {
+        size_t buffer;
+        std::string error;
+    };
+
+    void work()
+    {
+        while (true)
+        {
+            Operation op;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                submitted_cv_.wait(lock, [this] { return !submitted_.empty() || stopping_; });
+                if (submitted_.empty())
+                {
+                    return;
+                }
+                op = submitted_.front();
+                submitted_.pop_front();
+            }
+
+            Completion completion = { op.buffer, "" };
+            try
+            {
+                transfer_fully(op.fd, op.write, buffers_[op.buffer], op.size, op.offset);
+            }
+            catch (std::exception const &err)
+            {
+                completion.error = err.what();
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                completed_.push_back(completion);
+            }
+            completed_cv_.notify_one();
+        }
+    }
+
+    bool stopping_;
+    std::vector<std::thread> workers_;
+    std::deque<Operation> submitted_;
+    std::deque<Completion> completed_;
+    std::mutex mutex_;
+    std::condition_variable submitted_cv_;
+    std::condition_variable completed_cv_;
+};
+
+#ifdef HAS_IO_URING
+int io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+int io_uring_register(int ring_fd, unsigned opcode, void *arg, unsigned num_args)
+{
+    return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, num_args);
+}
+
+// io_uring backend, driven through the raw syscalls. The buffer pool is registered with the kernel up front so
+// fixed reads and writes skip per-operation page pinning. If registration is refused (e.g. RLIMIT_MEMLOCK) we fall
+// back to vectored operations on the same buffers.
+class IoUringIo : public AsyncIo
+{
+  public:
+    IoUringIo(size_t queue_depth, size_t buffer_size)
+        : AsyncIo(queue_depth, buffer_size)
+        , ring_fd_(-1)
+        , sq_ring_(MAP_FAILED)
+        , cq_ring_(MAP_FAILED)
+        , sqes_(MAP_FAILED)
+        , sq_ring_size_(0)
+        , cq_ring_size_(0)
+        , sqes_size_(0)
+        , registered_(false)
+        , to_submit_(0)
+    {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd_ = io_uring_setup((unsigned)queue_depth, &params);
+        if (ring_fd_ < 0)
+        {
+            throw std::runtime_error("io_uring_setup failed.");
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED)
+        {
+            release();
+            throw std::runtime_error("Failed to map io_uring.");
+        }
+
+        char *sq = static_cast<char *>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+        char *cq = static_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        operations_.resize(buffers_.size());
+        iovecs_.resize(buffers_.size());
+        for (size_t i = 0; i < buffers_.size(); ++i)
+        {
+            iovecs_[i].iov_base = buffers_[i];
+            iovecs_[i].iov_len = buffer_size_;
+        }
+        registered_ = io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, &iovecs_[0], (unsigned)iovecs_.size()) == 0;
+    }
+
+    ~IoUringIo()
+    {
+        drain();
+        release();
+    }
+
+    char const *name() const override { return registered_ ? "io_uring (registered buffers)" : "io_uring"; }
+
+  protected:
+    void submit(Operation const &op) override
+    {
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & sq_mask_;
+        struct io_uring_sqe *sqe = &static_cast<struct io_uring_sqe *>(sqes_)[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = op.fd;
+        sqe->off = op.offset;
+        sqe->user_data = op.buffer;
+        if (registered_)
+        {
+            sqe->opcode = op.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe->addr = (unsigned long long)buffers_[op.buffer];
+            sqe->len = (unsigned)op.size;
+            sqe->buf_index = (unsigned short)op.buffer;
+        }
+        else
+        {
+            iovecs_[op.buffer].iov_len = op.size;
+            sqe->opcode = op.write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->addr = (unsigned long long)&iovecs_[op.buffer];
+            sqe->len = 1;
+        }
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        operations_[op.buffer] = op;
+        ++to_submit_;
+    }
+
+    size_t wait(std::string &error) override
+    {
+        while (true)
+        {
+            unsigned head = *cq_head_;
+            if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+            {
+                struct io_uring_cqe cqe = cqes_[head & cq_mask_];
+                __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+                return complete(cqe, error);
+            }
+
+            int result = io_uring_enter(ring_fd_, to_submit_, 1, IORING_ENTER_GETEVENTS);
+            if (result < 0 && errno != EINTR)
+            {
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + strerror(errno));
+            }
+            if (result > 0)
+            {
+                to_submit_ -= std::min((unsigned)result, to_submit_);
+            }
+        }
+    }
+
+  private:
+    size_t complete(struct io_uring_cqe const &cqe, std::string &error)
+    {
+        size_t buffer = (size_t)cqe.user_data;
+        Operation const &op = operations_[buffer];
+        error.clear();
+        if (cqe.res < 0)
+        {
+            error = std::string(op.write ? "Write" : "Read") + " failed: " + strerror(-cqe.res);
+        }
+        else if ((size_t)cqe.res < op.size)
+        {
+            // Short transfer. Finish the remainder synchronously; this only happens at the edges of a file.
+            try
+            {
+                transfer_fully(op.fd, op.write, buffers_[buffer] + cqe.res, op.size - cqe.res, op.offset + cqe.res);
+            }
+            catch (std::exception const &err)
+            {
+                error = err.what();
+            }
+        }
+        return buffer;
+    }
+
+    void release()
+    {
+        if (sqes_ != MAP_FAILED)
+        {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED)
+        {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED)
+        {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0)
+        {
+            close(ring_fd_);
+        }
+    }
+
+    int ring_fd_;
+    void *sq_ring_;
+    void *cq_ring_;
+    void *sqes_;
+    size_t sq_ring_size_;
+    size_t cq_ring_size_;
+    size_t sqes_size_;
+    unsigned *sq_tail_;
+    unsigned sq_mask_;
+    unsigned *sq_array_;
+    unsigned *cq_head_;
+    unsigned *cq_tail_;
+    unsigned cq_mask_;
+    struct io_uring_cqe *cqes_;
+    std::vector<struct iovec> iovecs_;
+    std::vector<Operation> operations_;
+    bool registered_;
+    unsigned to_submit_;
+};
+#endif
+
+} // namespace
+
+AsyncIo::AsyncIo(size_t queue_depth, size_t buffer_size)
+    : queue_depth_(std::max(queue_depth, (size_t)1))
+    , buffer_size_(((std::max(buffer_size, (size_t)1) + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT) * BUFFER_ALIGNMENT)
+    , in_flight_(0)
+{
+    for (size_t i = 0; i < queue_depth_; ++i)
+    {
+        char *buffer = static_cast<char *>(aligned_alloc(BUFFER_ALIGNMENT, buffer_size_));
+        if (buffer == nullptr)
+        {
+            for (size_t j = 0; j < buffers_.size(); ++j)
+            {
+                free(buffers_[j]);
+            }
+            throw std::bad_alloc();
+        }
+        buffers_.push_back(buffer);
+    }
+}
+
+AsyncIo::~AsyncIo()
+{
+    for (size_t i = 0; i < buffers_.size(); ++i)
+    {
+        free(buffers_[i]);
+    }
+}
+
+void AsyncIo::drain()
+{
+    std::string error;
+    try
+    {
+        while (in_flight_ > 0)
+        {
+            wait(error);
+            --in_flight_;
+        }
+    }
+    catch (std::exception const &)
+    {
+        // The backend itself has failed, so nothing more will complete.
+        in_flight_ = 0;
+    }
+}
+
+void AsyncIo::read(std::vector<ReadRequest> const &requests, ReadCallback const &on_chunk)
+{
+    std::vector<std::string> paths;
+    std::vector<Chunk> chunks;
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        paths.push_back(requests[i].path);
+        add_chunks(chunks, i, requests[i].offset, requests[i].size);
+    }
+    run(chunks, paths, O_RDONLY, nullptr, &on_chunk);
+}
+
+void AsyncIo::write(std::vector<WriteRequest> const &requests)
+{
+    std::vector<std::string> paths;
+    std::vector<Chunk> chunks;
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        paths.push_back(requests[i].path);
+        add_chunks(chunks, i, requests[i].offset, requests[i].size);
+    }
+    run(chunks, paths, O_WRONLY | O_CREAT, &requests, nullptr);
+}
+
+void AsyncIo::add_chunks(std::vector<Chunk> &chunks, size_t request, size_t offset, size_t size)
+{
+    for (size_t request_offset = 0; request_offset < size; request_offset += buffer_size_)
+    {
+        size_t chunk_size = std::min(buffer_size_, size - request_offset);
+        chunks.push_back({ request, offset + request_offset, request_offset, chunk_size, request_offset + chunk_size == size });
+    }
+}
+
+// Keeps the pipeline full. Completed reads are held until every earlier chunk has been delivered, so callbacks
+// see chunks in order (which lets callers hash as they decode), while the kernel is free to complete them in any.
+// Each file is opened when its first chunk is submitted and closed once its last is delivered, so a long list of
+// small files never holds more than queue_depth descriptors.
+void AsyncIo::run(std::vector<Chunk> const &chunks,
+                  std::vector<std::string> const &paths,
+                  int flags,
+                  std::vector<WriteRequest> const *writes,
+                  ReadCallback const *on_chunk)
+{
+    std::vector<int> fds(paths.size(), -1);
+    std::vector<size_t> free_buffers;
+    for (size_t i = 0; i < queue_depth_; ++i)
+    {
+        free_buffers.push_back(queue_depth_ - 1 - i);
+    }
+    std::vector<size_t> buffer_chunk(queue_depth_);
+    std::vector<bool> buffer_complete(queue_depth_, false);
+    std::vector<size_t> sequence_buffer(queue_depth_);
+    size_t submitted = 0;
+    size_t delivered = 0;
+
+    try
+    {
+        while (delivered < chunks.size())
+        {
+            while (!free_buffers.empty() && submitted < chunks.size())
+            {
+                Chunk const &chunk = chunks[submitted];
+                if (fds[chunk.request] == -1)
+                {
+                    fds[chunk.request] = open(paths[chunk.request].c_str(), flags, 0644);
+                    if (fds[chunk.request] == -1)
+                    {
+                        throw std::runtime_error("Failed to open " + paths[chunk.request] + ".");
+                    }
+                }
+                size_t buffer = free_buffers.back();
+                free_buffers.pop_back();
+                if (writes)
+                {
+                    memcpy(buffers_[buffer], (*writes)[chunk.request].data + chunk.request_offset, chunk.size);
+                }
+                buffer_chunk[buffer] = submitted;
+                buffer_complete[buffer] = false;
+                sequence_buffer[submitted % queue_depth_] = buffer;
+                submit({ fds[chunk.request], writes != nullptr, chunk.file_offset, chunk.size, buffer });
+                ++in_flight_;
+                ++submitted;
+            }
+
+            std::string error;
+            size_t buffer = wait(error);
+            --in_flight_;
+            if (!error.empty())
+            {
+                throw std::runtime_error(error);
+            }
+            buffer_complete[buffer] = true;
+
+            while (delivered < submitted && buffer_complete[sequence_buffer[delivered % queue_depth_]])
+            {
+                size_t ready = sequence_buffer[delivered % queue_depth_];
+                Chunk const &chunk = chunks[buffer_chunk[ready]];
+                if (on_chunk)
+                {
+                    (*on_chunk)(chunk.request, chunk.request_offset, buffers_[ready], chunk.size);
+                }
+                if (chunk.last)
+                {
+                    close(fds[chunk.request]);
+                    fds[chunk.request] = -1;
+                }
+                buffer_complete[ready] = false;
+                free_buffers.push_back(ready);
+                ++delivered;
+            }
+        }
+    }
+    catch (...)
+    {
+        drain();
+        close_all(fds);
+        throw;
+    }
+}
+
+std::unique_ptr<AsyncIo> create_async_io(size_t queue_depth, size_t buffer_size, AsyncIoBackend backend)
+{
+#ifdef HAS_IO_URING
+    if (backend != AsyncIoBackend::THREADS)
+    {
+        try
+        {
+            return std::unique_ptr<AsyncIo>(new IoUringIo(queue_depth, buffer_size));
+        }
+        catch (std::runtime_error const &)
+        {
+            // Kernel too old, or io_uring disabled (e.g. by a container seccomp profile).
+            if (backend == AsyncIoBackend::IO_URING)
+            {
+                throw;
+            }
+        }
+    }
+#else
+    if (backend == AsyncIoBackend::IO_URING)
+    {
+        throw std::runtime_error("io_uring is not available in this build.");
+    }
+#endif
+    return std::unique_ptr<AsyncIo>(new ThreadPoolIo(queue_depth, buffer_size));
+}
+
+} // namespace streaming
@@ -0,0 +1,115 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include <stddef.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace streaming
+{
+
+struct ReadRequest
+{
+    std::string path;
+    size_t offset;
+    size_t size;
+};
+
+// Writes go to the given offset of an existing file (or a new one). The file is not truncated.
+struct WriteRequest
+{
+    std::string path;
+    size_t offset;
+    char const *data;
+    size_t size;
+};
+
+// Called for each chunk of a read: request index, offset of the chunk within the request, chunk data and size.
+// Chunks are delivered in request order, and never span two requests. Chunk boundaries fall on multiples of the
+// buffer size from the start of each request, so a request starting on an element boundary yields whole elements.
+using ReadCallback = std::function<void(size_t, size_t, char const *, size_t)>;
+
+enum class AsyncIoBackend
+{
+    AUTO,
+    IO_URING,
+    THREADS,
+};
+
+// Keeps up to queue_depth reads or writes in flight against a fixed pool of buffers.
+// Read callbacks run on the calling thread while later chunks are still outstanding, so decoding a chunk overlaps
+// with the I/O of those that follow. Instances are not thread safe; use one per thread.
+class AsyncIo
+{
+  public:
+    virtual ~AsyncIo();
+
+    void read(std::vector<ReadRequest> const &requests, ReadCallback const &on_chunk);
+
+    void write(std::vector<WriteRequest> const &requests);
+
+    virtual char const *name() const = 0;
+
+    size_t buffer_size() const { return buffer_size_; }
+
+  protected:
+    struct Operation
+    {
+        int fd;
+        bool write;
+        size_t offset;
+        size_t size;
+        size_t buffer;
+    };
+
+    AsyncIo(size_t queue_depth, size_t buffer_size);
+
+    // Queues an operation on buffers_[op.buffer]. It may not start until the next call to wait().
+    virtual void submit(Operation const &op) = 0;
+
+    // Blocks until an operation completes, and returns its buffer index. If the operation failed, error is set.
+    virtual size_t wait(std::string &error) = 0;
+
+    // Waits out every operation still in flight, ignoring failures. Backends must call this from their destructor.
+    void drain();
+
+    size_t queue_depth_;
+    size_t buffer_size_;
+    std::vector<char *> buffers_;
+    size_t in_flight_;
+
+  private:
+    struct Chunk
+    {
+        size_t request;
+        size_t file_offset;
+        size_t request_offset;
+        size_t size;
+        bool last;
+    };
+
+    AsyncIo(const AsyncIo &);
+    AsyncIo &operator=(const AsyncIo &);
+
+    void add_chunks(std::vector<Chunk> &chunks, size_t request, size_t offset, size_t size);
+
+    void run(std::vector<Chunk> const &chunks,
+             std::vector<std::string> const &paths,
+             int flags,
+             std::vector<WriteRequest> const *writes,
+             ReadCallback const *on_chunk);
+};
+
+constexpr size_t DEFAULT_QUEUE_DEPTH = 32;
+constexpr size_t DEFAULT_IO_BUFFER_SIZE = 1024 * 1024;
+
+// AUTO uses io_uring where the kernel allows it, and a pool of threads issuing blocking preads otherwise.
+std::unique_ptr<AsyncIo> create_async_io(size_t queue_depth = DEFAULT_QUEUE_DEPTH,
+                                         size_t buffer_size = DEFAULT_IO_BUFFER_SIZE,
+                                         AsyncIoBackend backend = AsyncIoBackend::AUTO);
+
+} // namespace streaming
@@ -0,0 +1,162 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "field_conversion.hpp"
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAS_X86_SHUFFLE 1
+#endif
+
+namespace field_conversion
+{
+
+namespace
+{
+
+typedef unsigned __int128 uint128_t;
+
+void byteswap_words_scalar(void *dst, void const *src, size_t num_words)
+{
+    char *out = static_cast<char *>(dst);
+    char const *in = static_cast<char const *>(src);
+    for (size_t i = 0; i < num_words; ++i)
+    {
+        uint64_t word;
+        memcpy(&word, in + i * sizeof(uint64_t), sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        memcpy(out + i * sizeof(uint64_t), &word, sizeof(uint64_t));
+    }
+}
+
+#ifdef HAS_X86_SHUFFLE
+__attribute__((target("ssse3"))) void byteswap_words_ssse3(void *dst, void const *src, size_t num_words)
+{
+    const __m128i mask = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    char *out = static_cast<char *>(dst);
+    char const *in = static_cast<char const *>(src);
+    size_t i = 0;
+    for (; i + 2 <= num_words; i += 2)
+    {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i * sizeof(uint64_t)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * sizeof(uint64_t)), _mm_shuffle_epi8(words, mask));
+    }
+    byteswap_words_scalar(out + i * sizeof(uint64_t), in + i * sizeof(uint64_t), num_words - i);
+}
+
+__attribute__((target("avx2"))) void byteswap_words_avx2(void *dst, void const *src, size_t num_words)
+{
+    // _mm256_shuffle_epi8 shuffles within each 128 bit lane, so the mask repeats.
+    const __m256i mask = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                         8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    char *out = static_cast<char *>(dst);
+    char const *in = static_cast<char const *>(src);
+    size_t i = 0;
+    for (; i + 4 <= num_words; i += 4)
+    {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i * sizeof(uint64_t)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i * sizeof(uint64_t)), _mm256_shuffle_epi8(words, mask));
+    }
+    byteswap_words_scalar(out + i * sizeof(uint64_t), in + i * sizeof(uint64_t), num_words - i);
+}
+#endif
+
+typedef void (*byteswap_fn)(void *, void const *, size_t);
+
+byteswap_fn select_byteswap()
+{
+#if defined(HAS_X86_SHUFFLE) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return byteswap_words_avx2;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return byteswap_words_ssse3;
+    }
+#endif
+    return byteswap_words_scalar;
+}
+
+// Coarsely integrated operand scanning (CIOS) Montgomery multiplication, specialised to 4 limbs.
+inline void montgomery_multiply(uint64_t *r, uint64_t const *a, uint64_t const *b, uint64_t const *p, uint64_t inv)
+{
+    uint64_t t[NUM_LIMBS + 2] = {0, 0, 0, 0, 0, 0};
+    for (size_t i = 0; i < NUM_LIMBS; ++i)
+    {
+        uint128_t acc = 0;
+        for (size_t j = 0; j < NUM_LIMBS; ++j)
+        {
+            acc = (uint128_t)a[j] * b[i] + t[j] + (uint64_t)(acc >> 64);
+            t[j] = (uint64_t)acc;
+        }
+        acc = (uint128_t)t[NUM_LIMBS] + (uint64_t)(acc >> 64);
+        t[NUM_LIMBS] = (uint64_t)acc;
+        t[NUM_LIMBS + 1] = (uint64_t)(acc >> 64);
+
+        uint64_t m = t[0] * inv;
+        acc = (uint128_t)m * p[0] + t[0];
+        for (size_t j = 1; j < NUM_LIMBS; ++j)
+        {
+            acc = (uint128_t)m * p[j] + t[j] + (uint64_t)(acc >> 64);
+            t[j - 1] = (uint64_t)acc;
+        }
+        acc = (uint128_t)t[NUM_LIMBS] + (uint64_t)(acc >> 64);
+        t[NUM_LIMBS - 1] = (uint64_t)acc;
+        t[NUM_LIMBS] = t[NUM_LIMBS + 1] + (uint64_t)(acc >> 64);
+    }
+
+    // The result is below 2p, so at most one subtraction brings it into range.
+    bool subtract = t[NUM_LIMBS] != 0;
+    if (!subtract)
+    {
+        subtract = true;
+        for (size_t j = NUM_LIMBS; j-- > 0;)
+        {
+            if (t[j] != p[j])
+            {
+                subtract = t[j] > p[j];
+                break;
+            }
+        }
+    }
+    if (subtract)
+    {
+        uint64_t borrow = 0;
+        for (size_t j = 0; j < NUM_LIMBS; ++j)
+        {
+            uint128_t diff = (uint128_t)t[j] - p[j] - borrow;
+            t[j] = (uint64_t)diff;
+            borrow = (uint64_t)(diff >> 64) & 1;
+        }
+    }
+    memcpy(r, t, NUM_LIMBS * sizeof(uint64_t));
+}
+
+} // namespace
+
+void byteswap_words(void *dst, void const *src, size_t num_words)
+{
+    static const byteswap_fn byteswap = select_byteswap();
+    byteswap(dst, src, num_words);
+}
+
+void montgomery_multiply_batch(uint64_t *dst, uint64_t const *src, size_t num_elements, uint64_t const *b, uint64_t const *modulus, uint64_t inv)
+{
+    // Copy the constants locally, so the compiler can keep them in registers across the whole batch.
+    uint64_t multiplier[NUM_LIMBS];
+    uint64_t p[NUM_LIMBS];
+    memcpy(multiplier, b, sizeof(multiplier));
+    memcpy(p, modulus, sizeof(p));
+    for (size_t i = 0; i < num_elements; ++i)
+    {
+        montgomery_multiply(dst + i * NUM_LIMBS, src + i * NUM_LIMBS, multiplier, p, inv);
+    }
+}
+
+} // namespace field_conversion
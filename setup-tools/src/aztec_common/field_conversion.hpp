@@ -0,0 +1,52 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace field_conversion
+{
+
+constexpr size_t NUM_LIMBS = 4;
+
+// Byte swaps each 64-bit word, converting between the transcript's big-endian limbs and host order.
+// Uses AVX2 or SSSE3 shuffles where the CPU has them. dst and src may alias, and need not be aligned.
+void byteswap_words(void *dst, void const *src, size_t num_words);
+
+// Montgomery multiplies each 4-limb element of src by b, writing fully reduced results to dst (which may alias src).
+// inv is -modulus^-1 mod 2^64. Multiplying by R^2 converts into Montgomery form, multiplying by 1 converts out of it.
+void montgomery_multiply_batch(uint64_t *dst, uint64_t const *src, size_t num_elements, uint64_t const *b, uint64_t const *modulus, uint64_t inv);
+
+// Decodes num_elements transcript-encoded field elements straight into libff's Montgomery representation.
+// Any 256 bit input is reduced, exactly as FieldT(bigint) would.
+template <typename FieldT>
+void decode_field_elements(FieldT *elements, char const *buffer, size_t num_elements)
+{
+    static_assert(sizeof(FieldT) == NUM_LIMBS * sizeof(uint64_t), "Expected a 4 limb field.");
+    static_assert(sizeof(elements->mont_repr.data[0]) == sizeof(uint64_t), "Expected 64 bit limbs.");
+
+    uint64_t *limbs = reinterpret_cast<uint64_t *>(elements);
+    byteswap_words(limbs, buffer, num_elements * NUM_LIMBS);
+    montgomery_multiply_batch(limbs, limbs, num_elements, reinterpret_cast<uint64_t const *>(FieldT::Rsquared.data),
+                              reinterpret_cast<uint64_t const *>(FieldT::mod.data), FieldT::inv);
+}
+
+// Encodes num_elements field elements into the transcript encoding, as as_bigint() followed by a limb byte swap would.
+template <typename FieldT>
+void encode_field_elements(char *buffer, FieldT const *elements, size_t num_elements)
+{
+    static_assert(sizeof(FieldT) == NUM_LIMBS * sizeof(uint64_t), "Expected a 4 limb field.");
+    static_assert(sizeof(elements->mont_repr.data[0]) == sizeof(uint64_t), "Expected 64 bit limbs.");
+
+    const uint64_t one[NUM_LIMBS] = {1, 0, 0, 0};
+    std::vector<uint64_t> limbs(num_elements * NUM_LIMBS);
+    montgomery_multiply_batch(&limbs[0], reinterpret_cast<uint64_t const *>(elements), num_elements, one,
+                              reinterpret_cast<uint64_t const *>(FieldT::mod.data), FieldT::inv);
+    byteswap_words(buffer, &limbs[0], num_elements * NUM_LIMBS);
+}
+
+} // namespace field_conversion
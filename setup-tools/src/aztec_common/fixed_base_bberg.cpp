@@ -0,0 +1,241 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "fixed_base_bberg.hpp"
+#include "pippenger.hpp"
+#include "pippenger_bberg.hpp"
+#include "thread_pool.hpp"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace fixed_base
+{
+
+namespace
+{
+
+// Points whose multiples are computed, and normalized together, per task.
+constexpr size_t POINTS_PER_TASK = 1024;
+
+// Points read, and their multiples written, at a time by write_table, which bounds its memory.
+constexpr size_t POINTS_PER_WRITE = 1 << 18;
+
+struct Header
+{
+    uint64_t window_bits;
+    uint64_t num_points;
+};
+
+} // namespace
+
+void compute_table(bb::g1::affine_element const *points, size_t num_points, size_t window_bits, bb::g1::affine_element *table)
+{
+    const size_t windows = num_windows(window_bits);
+    parallel::parallel_for((num_points + POINTS_PER_TASK - 1) / POINTS_PER_TASK, [&](size_t task) {
+        const size_t start = task * POINTS_PER_TASK;
+        const size_t end = std::min(num_points, start + POINTS_PER_TASK);
+
+        // The first window's multiple is the point itself, and is copied as is.
+        std::vector<bb::g1::element> multiples((end - start) * (windows - 1));
+        for (size_t i = start; i < end; ++i)
+        {
+            table[i * windows] = points[i];
+            bb::g1::element multiple;
+            bb::g1::set_infinity(multiple);
+            bb::g1::mixed_add(multiple, points[i], multiple);
+            for (size_t j = 1; j < windows; ++j)
+            {
+                for (size_t k = 0; k < window_bits; ++k)
+                {
+                    bb::g1::dbl(multiple, multiple);
+                }
+                multiples[(i - start) * (windows - 1) + j - 1] = multiple;
+            }
+        }
+
+        bb::g1::batch_normalize(&multiples[0], multiples.size());
+        for (size_t i = start; i < end; ++i)
+        {
+            for (size_t j = 1; j < windows; ++j)
+            {
+                table[i * windows + j].x = multiples[(i - start) * (windows - 1) + j - 1].x;
+                table[i * windows + j].y = multiples[(i - start) * (windows - 1) + j - 1].y;
+            }
+        }
+    });
+}
+
+void write_table(std::string const &points_path, size_t num_points, size_t window_bits, std::string const &output_path)
+{
+    if (window_bits < 2 || window_bits > pippenger::MAX_WINDOW_BITS)
+    {
+        throw std::runtime_error("Window size must be from 2 to " + std::to_string(pippenger::MAX_WINDOW_BITS) + " bits.");
+    }
+
+    std::ifstream input(points_path, std::ios::binary | std::ios::ate);
+    if (!input)
+    {
+        throw std::runtime_error("Failed to open " + points_path);
+    }
+    if ((size_t)input.tellg() / sizeof(bb::g1::affine_element) < num_points)
+    {
+        throw std::runtime_error(points_path + " has fewer than " + std::to_string(num_points) + " points.");
+    }
+    input.seekg(0);
+
+    std::ofstream output(output_path, std::ios::binary);
+    const Header header = { window_bits, num_points };
+    output.write((char *)&header, sizeof(header));
+
+    const size_t windows = num_windows(window_bits);
+    std::vector<bb::g1::affine_element> points;
+    std::vector<bb::g1::affine_element> table;
+    for (size_t start = 0; start < num_points && input && output; start += POINTS_PER_WRITE)
+    {
+        const size_t count = std::min(POINTS_PER_WRITE, num_points - start);
+        points.resize(count);
+        table.resize(count * windows);
+        input.read((char *)&points[0], count * sizeof(bb::g1::affine_element));
+        compute_table(&points[0], count, window_bits, &table[0]);
+        output.write((char *)&table[0], table.size() * sizeof(bb::g1::affine_element));
+    }
+
+    if (!input || !output)
+    {
+        throw std::runtime_error("Failed to write fixed-base table " + output_path);
+    }
+}
+
+Table map_table(std::string const &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1 || (size_t)sb.st_size < sizeof(Header))
+    {
+        close(fd);
+        throw std::runtime_error("Failed to read fixed-base table " + path);
+    }
+
+    void *data = mmap(0, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map fixed-base table " + path);
+    }
+
+    Header const &header = *(Header const *)data;
+    if (header.window_bits < 2 || header.window_bits > pippenger::MAX_WINDOW_BITS ||
+        (size_t)sb.st_size != sizeof(Header) + header.num_points * num_windows(header.window_bits) * sizeof(bb::g1::affine_element))
+    {
+        munmap(data, sb.st_size);
+        throw std::runtime_error("Fixed-base table " + path + " is malformed.");
+    }
+
+    return { header.window_bits, header.num_points, (bb::g1::affine_element const *)((char const *)data + sizeof(Header)) };
+}
+
+void check_table(Table const &table, bb::g1::affine_element const *points, size_t num_points)
+{
+    const size_t windows = num_windows(table.window_bits);
+    if (table.num_points < num_points ||
+        (num_points > 0 && (memcmp(&table.points[0], &points[0], sizeof(bb::g1::affine_element)) != 0 ||
+                            memcmp(&table.points[(num_points - 1) * windows], &points[num_points - 1], sizeof(bb::g1::affine_element)) != 0)))
+    {
+        throw std::runtime_error("Fixed-base table does not match the points.");
+    }
+}
+
+bb::g1::element multi_exp(Table const &table, size_t first_point, bb::fr::field_t const *scalars, size_t num_points, std::function<void(size_t, size_t, size_t)> const &prepare_chunk)
+{
+    if (first_point + num_points > table.num_points)
+    {
+        throw std::runtime_error("Fixed-base table has too few points.");
+    }
+
+    bb::g1::element result = { .x = { 0 }, .y = { 0 }, .z = { 0 } };
+    bb::g1::set_infinity(result);
+    if (num_points == 0)
+    {
+        return result;
+    }
+
+    const size_t window_bits = table.window_bits;
+    const size_t windows = num_windows(window_bits);
+    const int64_t half = (int64_t)1 << (window_bits - 1);
+    const size_t num_chunks = pippenger::multi_exp_bberg_chunks(num_points);
+    std::vector<bb::g1::element> results(num_chunks);
+
+    parallel::parallel_for(num_chunks, [&](size_t chunk) {
+        const size_t start = chunk * num_points / num_chunks;
+        const size_t end = (chunk + 1) * num_points / num_chunks;
+        if (prepare_chunk)
+        {
+            prepare_chunk(chunk, start, end);
+        }
+
+        // Bucket b holds the multiples with digit b + 1, and the negations of those with digit -(b + 1).
+        std::vector<bb::g1::element> buckets(half);
+        for (auto &bucket : buckets)
+        {
+            bb::g1::set_infinity(bucket);
+        }
+
+        for (size_t i = start; i < end; ++i)
+        {
+            bb::fr::field_t scalar;
+            bb::fr::from_montgomery_form(scalars[i], scalar);
+            bb::g1::affine_element const *multiples = table.points + (first_point + i) * windows;
+
+            // A digit above half borrows 2^window_bits from the next window up.
+            int64_t carry = 0;
+            for (size_t j = 0; j < windows; ++j)
+            {
+                int64_t digit = (int64_t)pippenger::get_digit(scalar, j * window_bits, window_bits) + carry;
+                carry = digit > half ? 1 : 0;
+                digit -= carry << window_bits;
+                if (digit > 0)
+                {
+                    bb::g1::mixed_add(buckets[digit - 1], multiples[j], buckets[digit - 1]);
+                }
+                else if (digit < 0)
+                {
+                    bb::g1::affine_element negated;
+                    bb::g1::neg(multiples[j], negated);
+                    bb::g1::mixed_add(buckets[-digit - 1], negated, buckets[-digit - 1]);
+                }
+            }
+        }
+
+        // 1.buckets[0] + 2.buckets[1] + ..., accumulated from the top down.
+        bb::g1::element running;
+        bb::g1::element sum;
+        bb::g1::set_infinity(running);
+        bb::g1::set_infinity(sum);
+        for (size_t b = buckets.size(); b-- > 0;)
+        {
+            bb::g1::add(running, buckets[b], running);
+            bb::g1::add(sum, running, sum);
+        }
+        results[chunk] = sum;
+    });
+
+    for (auto const &r : results)
+    {
+        bb::g1::add(r, result, result);
+    }
+    return result;
+}
+
+} // namespace fixed_base
@@ -0,0 +1,61 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include <barretenberg/fields/fr.hpp>
+#include <barretenberg/groups/g1.hpp>
+#include <stddef.h>
+#include <functional>
+#include <string>
+
+// Fixed-base multi-exponentiation, for points that are used again and again with different scalars, such as the powers
+// of x that every range point is computed against. A one-time table holds 2^(c.j).P for every point P and every c-bit
+// window j, so that a multi-exponentiation is a single pass of bucket additions: there are no doublings, and the
+// buckets are summed once rather than once per window. Digits are signed, from -2^(c-1) to 2^(c-1), which halves the
+// buckets, as negating an affine point is free.
+namespace fixed_base
+{
+
+namespace bb = barretenberg;
+
+constexpr size_t DEFAULT_WINDOW_BITS = 16;
+
+// Scalars are below the modulus of Fr, which has 254 bits.
+constexpr size_t SCALAR_BITS = 254;
+
+// The top window must have room for the carry out of the one below it.
+inline size_t num_windows(size_t window_bits)
+{
+    return (SCALAR_BITS + window_bits) / window_bits;
+}
+
+// Point i's multiples are points[i.num_windows(window_bits) + j], for each window j.
+struct Table
+{
+    size_t window_bits;
+    size_t num_points;
+    bb::g1::affine_element const *points;
+};
+
+// Fills table with the multiples of points[0], ..., points[num_points - 1], affine, on the shared thread pool.
+void compute_table(bb::g1::affine_element const *points, size_t num_points, size_t window_bits, bb::g1::affine_element *table);
+
+// Writes the table of the first num_points points in the file at points_path, which holds affine points in memory
+// format, as g1x_prep.dat does. The file is a header of the window size and the number of points, as 64-bit integers,
+// followed by the table in memory format, so that it can be mapped.
+void write_table(std::string const &points_path, size_t num_points, size_t window_bits, std::string const &output_path);
+
+// Maps a file written by write_table. It stays mapped for the life of the process.
+Table map_table(std::string const &path);
+
+// Throws unless the table holds at least num_points points, starting with those given. The first and last points are
+// compared, which catches a table of some other points.
+void check_table(Table const &table, bb::g1::affine_element const *points, size_t num_points);
+
+// scalars[0].P_first + ... + scalars[num_points - 1].P_(first + num_points - 1), for the points P of the table, on the
+// shared thread pool. The work is split into the chunks pippenger::multi_exp_bberg would use, with prepare_chunk
+// likewise called by each chunk's task before it reads its scalars. The scalars are not modified.
+bb::g1::element multi_exp(Table const &table, size_t first_point, bb::fr::field_t const *scalars, size_t num_points, std::function<void(size_t, size_t, size_t)> const &prepare_chunk = nullptr);
+
+} // namespace fixed_base
@@ -0,0 +1,111 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "multi_pairing.hpp"
+#include "thread_pool.hpp"
+
+namespace pairing
+{
+
+G2PrecomputeCache::G2PrecomputeCache(size_t max_entries)
+    : max_entries_(max_entries)
+{
+}
+
+std::shared_ptr<const G2_precomp> G2PrecomputeCache::get(G2 const &point)
+{
+    // Points are identified by their affine coordinates.
+    G2 affine = point;
+    affine.to_affine_coordinates();
+    std::string key = std::string((char const *)&affine.X, sizeof(affine.X)) + std::string((char const *)&affine.Y, sizeof(affine.Y));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end())
+        {
+            return it->second;
+        }
+    }
+
+    auto precompute = std::make_shared<const G2_precomp>(ppT::precompute_G2(affine));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.emplace(key, precompute).second)
+    {
+        order_.push_back(key);
+        if (order_.size() > max_entries_)
+        {
+            entries_.erase(order_.front());
+            order_.pop_front();
+        }
+    }
+    return precompute;
+}
+
+MultiPairing::Pair &MultiPairing::find_or_add(G1 const &p, G2 const &q)
+{
+    for (auto &pair : pairs_)
+    {
+        if (pair.q == q)
+        {
+            pair.p = pair.p + p;
+            return pair;
+        }
+    }
+    pairs_.push_back({p, q, nullptr});
+    return pairs_.back();
+}
+
+void MultiPairing::add(G1 const &p, G2 const &q)
+{
+    // e(0, q) = e(p, 0) = 1.
+    if (p.is_zero() || q.is_zero())
+    {
+        return;
+    }
+    find_or_add(p, q);
+}
+
+void MultiPairing::add(G1 const &p, G2 const &q, G2PrecomputeCache &cache)
+{
+    if (p.is_zero() || q.is_zero())
+    {
+        return;
+    }
+    Pair &pair = find_or_add(p, q);
+    if (!pair.q_precomp)
+    {
+        pair.q_precomp = cache.get(q);
+    }
+}
+
+GT MultiPairing::evaluate() const
+{
+// turn off profiling printf statements when computing a pairing
+#ifndef ENABLE_LIBFF_PROFILING
+    libff::inhibit_profiling_info = true;
+    libff::inhibit_profiling_counters = true;
+#endif // ENABLE_LIBFF_PROFILING
+
+    std::vector<Fqk> miller_results(pairs_.size(), Fqk::one());
+    parallel::parallel_for(pairs_.size(), [&](size_t i) {
+        Pair const &pair = pairs_[i];
+        // G1 points sharing a G2 point can sum to zero.
+        if (pair.p.is_zero())
+        {
+            return;
+        }
+        G1_precomp p = ppT::precompute_G1(pair.p);
+        miller_results[i] = pair.q_precomp ? ppT::miller_loop(p, *pair.q_precomp) : ppT::miller_loop(p, ppT::precompute_G2(pair.q));
+    });
+
+    Fqk miller_result = Fqk::one();
+    for (auto const &result : miller_results)
+    {
+        miller_result = miller_result * result;
+    }
+    return ppT::final_exponentiation(miller_result);
+}
+
+} // namespace pairing
@@ -0,0 +1,68 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "libff_types.hpp"
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace pairing
+{
+
+// Number of G2 points a G2PrecomputeCache keeps the line coefficients of by default.
+constexpr size_t DEFAULT_CACHED_PRECOMPUTES = 16;
+
+// The Miller loop line coefficients of G2 points that recur across pairings, such as the generator, computed once
+// and shared. Beyond max_entries points the oldest are dropped. Safe to share between threads.
+class G2PrecomputeCache
+{
+  public:
+    explicit G2PrecomputeCache(size_t max_entries = DEFAULT_CACHED_PRECOMPUTES);
+
+    std::shared_ptr<const G2_precomp> get(G2 const &point);
+
+  private:
+    G2PrecomputeCache(const G2PrecomputeCache &);
+    G2PrecomputeCache &operator=(const G2PrecomputeCache &);
+
+    size_t max_entries_;
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<const G2_precomp>> entries_;
+    std::deque<std::string> order_;
+};
+
+// A product of pairings e(p_1, q_1) * ... * e(p_n, q_n). The Miller loops run in parallel on the shared thread pool,
+// and their product takes a single final exponentiation.
+class MultiPairing
+{
+  public:
+    // Multiplies in e(p, q). Pairs sharing a G2 point share a Miller loop, as e(p_1, q) * e(p_2, q) = e(p_1 + p_2, q).
+    void add(G1 const &p, G2 const &q);
+
+    // As above, taking q's line coefficients from cache.
+    void add(G1 const &p, G2 const &q, G2PrecomputeCache &cache);
+
+    // Number of Miller loops evaluate will run.
+    size_t size() const { return pairs_.size(); }
+
+    GT evaluate() const;
+
+    bool is_one() const { return evaluate() == GT::one(); }
+
+  private:
+    struct Pair
+    {
+        G1 p;
+        G2 q;
+        std::shared_ptr<const G2_precomp> q_precomp;
+    };
+
+    Pair &find_or_add(G1 const &p, G2 const &q);
+
+    std::vector<Pair> pairs_;
+};
+
+} // namespace pairing
@@ -0,0 +1,159 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "thread_pool.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Bucket (Pippenger) multi-exponentiation for libff groups.
+// Each c-bit window of the scalars sorts the points into 2^c buckets by their digit, and the buckets are then summed
+// weighted by digit with a running sum, so each window costs about n + 2^(c+1) additions rather than n scalar
+// multiplications.
+namespace pippenger
+{
+
+// Upper bound on the window size, which bounds the bucket memory per thread.
+constexpr size_t MAX_WINDOW_BITS = 20;
+
+// Points per thread below which splitting the work further costs more in bucket sums than it saves.
+constexpr size_t MIN_POINTS_PER_THREAD = 4096;
+
+// The window size that minimizes the additions needed for num_points scalars of scalar_bits bits.
+inline size_t window_bits(size_t num_points, size_t scalar_bits)
+{
+    size_t best_bits = 1;
+    size_t best_cost = std::numeric_limits<size_t>::max();
+    for (size_t bits = 1; bits <= MAX_WINDOW_BITS; ++bits)
+    {
+        size_t num_windows = (scalar_bits + bits - 1) / bits;
+        size_t cost = num_windows * (num_points + ((size_t)2 << bits));
+        if (cost < best_cost)
+        {
+            best_bits = bits;
+            best_cost = cost;
+        }
+    }
+    return best_bits;
+}
+
+// The bits-wide digit of scalar starting at bit, which may straddle two limbs.
+template <typename BigintT>
+size_t get_digit(BigintT const &scalar, size_t bit, size_t bits)
+{
+    constexpr size_t num_limbs = sizeof(scalar.data) / sizeof(scalar.data[0]);
+    constexpr size_t limb_bits = sizeof(scalar.data[0]) * 8;
+    const size_t limb = bit / limb_bits;
+    const size_t shift = bit % limb_bits;
+
+    uint64_t digit = scalar.data[limb] >> shift;
+    if (shift + bits > limb_bits && limb + 1 < num_limbs)
+    {
+        digit |= (uint64_t)scalar.data[limb + 1] << (limb_bits - shift);
+    }
+    return digit & (((uint64_t)1 << bits) - 1);
+}
+
+// Affine points (Z == 1) take the cheaper mixed addition.
+template <typename GroupT>
+void add_to_bucket(GroupT &bucket, GroupT const &point)
+{
+    bucket = point.is_special() ? bucket.mixed_add(point) : bucket + point;
+}
+
+// Scalars are either field elements, which are converted out of Montgomery form, or plain bigints.
+template <typename ScalarT>
+auto to_bigint(ScalarT const &scalar, int) -> decltype(scalar.as_bigint())
+{
+    return scalar.as_bigint();
+}
+
+template <typename ScalarT>
+ScalarT to_bigint(ScalarT const &scalar, long)
+{
+    return scalar;
+}
+
+// Single threaded multi-exponentiation over scalars already converted out of Montgomery form.
+template <typename GroupT, typename BigintT>
+GroupT multi_exp_serial(GroupT const *points, BigintT const *scalars, size_t num_points, size_t scalar_bits)
+{
+    GroupT result = GroupT::zero();
+    if (num_points == 0 || scalar_bits == 0)
+    {
+        return result;
+    }
+
+    const size_t bits = window_bits(num_points, scalar_bits);
+    const size_t num_windows = (scalar_bits + bits - 1) / bits;
+    std::vector<GroupT> buckets((size_t)1 << bits);
+
+    for (size_t window = num_windows; window-- > 0;)
+    {
+        if (window != num_windows - 1)
+        {
+            for (size_t i = 0; i < bits; ++i)
+            {
+                result = result.dbl();
+            }
+        }
+
+        std::fill(buckets.begin(), buckets.end(), GroupT::zero());
+        for (size_t i = 0; i < num_points; ++i)
+        {
+            size_t digit = get_digit(scalars[i], window * bits, bits);
+            if (digit)
+            {
+                add_to_bucket(buckets[digit], points[i]);
+            }
+        }
+
+        // sum = 1.buckets[1] + 2.buckets[2] + ..., accumulated from the top down.
+        GroupT running = GroupT::zero();
+        GroupT sum = GroupT::zero();
+        for (size_t digit = buckets.size() - 1; digit > 0; --digit)
+        {
+            running = running + buckets[digit];
+            sum = sum + running;
+        }
+        result = result + sum;
+    }
+    return result;
+}
+
+// Computes scalars[0].points[0] + ... + scalars[num_points - 1].points[num_points - 1] on the shared thread pool.
+// The points are split evenly across threads, each running its own bucket method, with a window sized for its
+// share. Only as many scalar bits as the largest scalar has are processed, so short scalars are cheaper.
+template <typename GroupT, typename ScalarT>
+GroupT multi_exp(GroupT const *points, ScalarT const *scalars, size_t num_points)
+{
+    parallel::ThreadPool &pool = parallel::default_thread_pool();
+    const size_t num_chunks = std::max((size_t)1, std::min(pool.size(), num_points / MIN_POINTS_PER_THREAD));
+    std::vector<GroupT> results(num_chunks, GroupT::zero());
+
+    pool.parallel_for(num_chunks, [&](size_t chunk) {
+        const size_t start = chunk * num_points / num_chunks;
+        const size_t end = (chunk + 1) * num_points / num_chunks;
+
+        std::vector<decltype(to_bigint(scalars[0], 0))> bigints(end - start);
+        size_t scalar_bits = 0;
+        for (size_t i = start; i < end; ++i)
+        {
+            bigints[i - start] = to_bigint(scalars[i], 0);
+            scalar_bits = std::max(scalar_bits, (size_t)bigints[i - start].num_bits());
+        }
+        results[chunk] = multi_exp_serial(points + start, bigints.data(), end - start, scalar_bits);
+    });
+
+    GroupT result = results[0];
+    for (size_t i = 1; i < num_chunks; ++i)
+    {
+        result = result + results[i];
+    }
+    return result;
+}
+
+} // namespace pippenger
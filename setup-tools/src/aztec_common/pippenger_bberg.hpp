@@ -0,0 +1,71 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "pippenger.hpp"
+#include "thread_pool.hpp"
+#include <barretenberg/fields/fr.hpp>
+#include <barretenberg/groups/g1.hpp>
+#include <barretenberg/groups/scalar_multiplication.hpp>
+#include <string.h>
+#include <functional>
+#include <vector>
+
+namespace pippenger
+{
+
+namespace bb = barretenberg;
+
+// The number of chunks multi_exp_bberg splits num_points into. Chunk c is the points from c.num_points / num_chunks up
+// to (c + 1).num_points / num_chunks.
+inline size_t multi_exp_bberg_chunks(size_t num_points)
+{
+    return std::max((size_t)1, std::min(parallel::default_thread_pool().size(), num_points / MIN_POINTS_PER_THREAD));
+}
+
+// Computes scalars[0].points[0] + ... + scalars[num_points - 1].points[num_points - 1] on the shared thread pool.
+// barretenberg's pippenger_low_memory runs on a single thread, so the points are split into one contiguous range per
+// thread, each thread streaming through only its own part of them, and the partial sums are added.
+// pippenger_low_memory clobbers its scalars. With copy_scalars, each task first copies its share into a buffer of its
+// own, which is then local to the thread that touched it first. Otherwise scalars are used, and clobbered, in place.
+// If given, prepare_chunk(chunk, start, end) is called by each chunk's task before it reads its scalars, so that work
+// finishing them overlaps with other chunks' multi-exponentiations.
+inline bb::g1::element multi_exp_bberg(bb::g1::affine_element *points, bb::fr::field_t *scalars, size_t num_points, bool copy_scalars, std::function<void(size_t, size_t, size_t)> const &prepare_chunk = nullptr)
+{
+    bb::g1::element result = { .x = { 0 }, .y = { 0 }, .z = { 0 } };
+    bb::g1::set_infinity(result);
+    if (num_points == 0)
+    {
+        return result;
+    }
+
+    const size_t num_chunks = multi_exp_bberg_chunks(num_points);
+    std::vector<bb::g1::element> results(num_chunks);
+
+    parallel::parallel_for(num_chunks, [&](size_t chunk) {
+        const size_t start = chunk * num_points / num_chunks;
+        const size_t end = (chunk + 1) * num_points / num_chunks;
+        if (prepare_chunk)
+        {
+            prepare_chunk(chunk, start, end);
+        }
+        std::vector<bb::fr::field_t> copy;
+        bb::fr::field_t *chunk_scalars = scalars + start;
+        if (copy_scalars)
+        {
+            copy.resize(end - start);
+            memcpy(&copy[0], scalars + start, (end - start) * sizeof(bb::fr::field_t));
+            chunk_scalars = &copy[0];
+        }
+        results[chunk] = bb::scalar_multiplication::pippenger_low_memory(chunk_scalars, points + start, end - start);
+    });
+
+    for (auto const &r : results)
+    {
+        bb::g1::add(r, result, result);
+    }
+    return result;
+}
+
+} // namespace pippenger
@@ -0,0 +1,126 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "point_checks.hpp"
+#include "pippenger.hpp"
+#include "thread_pool.hpp"
+#include <blake2.h>
+#include <atomic>
+#include <fstream>
+
+namespace point_checks
+{
+
+namespace
+{
+
+// Number of points checked, or coefficients generated, per task.
+constexpr size_t POINTS_PER_TASK = 4096;
+
+// The smallest prime factor of the G2 cofactor is 10069, so a random 16-bit combination of points misses a
+// component of any order dividing it with probability at most 7/2^16 < 2^-13. Ten independent combinations bring
+// that below 2^-128.
+constexpr size_t SUBGROUP_CHECK_ROUNDS = 10;
+
+// Below this many points, checking each on its own is cheaper than the rounds of multi-exponentiation.
+constexpr size_t MIN_BATCH_POINTS = 32;
+
+// 6u^2, for u = 4965661367192848881.
+libff::bigint<2> const &six_u_squared()
+{
+    static const libff::bigint<2> value("147946756881789318990833708069417712966");
+    return value;
+}
+
+template <typename GroupT>
+bool all_on_curve(GroupT const *points, size_t num_points)
+{
+    std::atomic<bool> valid(true);
+    parallel::parallel_for((num_points + POINTS_PER_TASK - 1) / POINTS_PER_TASK, [&](size_t task) {
+        const size_t end = std::min(num_points, (task + 1) * POINTS_PER_TASK);
+        for (size_t i = task * POINTS_PER_TASK; i < end && valid; ++i)
+        {
+            if (!points[i].is_well_formed() || points[i].is_zero())
+            {
+                valid = false;
+            }
+        }
+    });
+    return valid;
+}
+
+std::vector<unsigned char> random_seed()
+{
+    std::vector<unsigned char> seed(BLAKE2B_KEYBYTES);
+    std::ifstream urandom("/dev/urandom", std::ios::binary);
+    if (!urandom.read((char *)&seed[0], seed.size()))
+    {
+        throw std::runtime_error("Failed to read random seed.");
+    }
+    return seed;
+}
+
+} // namespace
+
+bool on_curve(G1 const *points, size_t num_points)
+{
+    return all_on_curve(points, num_points);
+}
+
+bool on_curve(G2 const *points, size_t num_points)
+{
+    return all_on_curve(points, num_points);
+}
+
+G2 psi(G2 const &point)
+{
+    return point.mul_by_q();
+}
+
+bool in_subgroup(G2 const &point)
+{
+    return psi(point) == six_u_squared() * point;
+}
+
+bool in_subgroup(G2 const *points, size_t num_points)
+{
+    if (num_points < MIN_BATCH_POINTS)
+    {
+        for (size_t i = 0; i < num_points; ++i)
+        {
+            if (!in_subgroup(points[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Each point's coefficients for every round come from Blake2b keyed with the seed, over the point's index.
+    const std::vector<unsigned char> seed = random_seed();
+    std::vector<libff::bigint<1>> coefficients(SUBGROUP_CHECK_ROUNDS * num_points);
+    parallel::parallel_for((num_points + POINTS_PER_TASK - 1) / POINTS_PER_TASK, [&](size_t task) {
+        const size_t end = std::min(num_points, (task + 1) * POINTS_PER_TASK);
+        for (uint64_t i = task * POINTS_PER_TASK; i < end; ++i)
+        {
+            uint16_t round_coefficients[SUBGROUP_CHECK_ROUNDS];
+            blake2b(round_coefficients, sizeof(round_coefficients), &i, sizeof(i), &seed[0], seed.size());
+            for (size_t round = 0; round < SUBGROUP_CHECK_ROUNDS; ++round)
+            {
+                coefficients[round * num_points + i].data[0] = round_coefficients[round];
+            }
+        }
+    });
+
+    for (size_t round = 0; round < SUBGROUP_CHECK_ROUNDS; ++round)
+    {
+        if (!in_subgroup(pippenger::multi_exp(points, &coefficients[round * num_points], num_points)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace point_checks
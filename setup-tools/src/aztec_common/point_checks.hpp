@@ -0,0 +1,38 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "libff_types.hpp"
+
+// Validity checks for points read from untrusted transcripts.
+// A point on the alt_bn128 G1 curve is always in G1, as the curve has prime order. The G2 twist curve has order
+// h.r for a cofactor h, so a point on it may also have a component of order dividing h, which has to be ruled out
+// separately.
+namespace point_checks
+{
+
+// Whether every point is on its curve and not the point at infinity, checked in parallel.
+bool on_curve(G1 const *points, size_t num_points);
+
+bool on_curve(G2 const *points, size_t num_points);
+
+// The untwist-Frobenius-twist endomorphism, which acts on G2 as multiplication by q.
+G2 psi(G2 const &point);
+
+// Whether a point on the twist curve is in G2, by checking psi(point) == [6u^2]point for the curve parameter u.
+// 6u^2 is congruent to q modulo r, and only points of G2 satisfy the equation. The scalar is half the length of
+// r, so this costs about half as much as checking [r]point is zero.
+bool in_subgroup(G2 const &point);
+
+// Whether every point is in its prime order subgroup. For G2 this takes a few multi-exponentiations of the points
+// with random 16-bit coefficients, each checked with the endomorphism as above, rather than a scalar
+// multiplication per point. A point outside G2 goes undetected with probability less than 2^-128.
+bool in_subgroup(G2 const *points, size_t num_points);
+
+inline bool in_subgroup(G1 const *, size_t)
+{
+    return true;
+}
+
+} // namespace point_checks
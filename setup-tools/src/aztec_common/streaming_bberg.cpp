@@ -0,0 +1,191 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "streaming_bberg.hpp"
+#include "field_conversion.hpp"
+#include "transcript_writer.hpp"
+
+namespace streaming
+{
+
+namespace
+{
+
+static_assert(sizeof(bb::g1::affine_element) == BBERG_G1_BYTES, "Unexpected barretenberg G1 layout.");
+static_assert(sizeof(bb::g2::affine_element) == BBERG_G2_BYTES, "Unexpected barretenberg G2 layout.");
+static_assert(!USE_COMPRESSION, "Barretenberg transcript I/O only supports uncompressed points.");
+
+// Number of points serialized at a time when streaming a transcript to disk.
+constexpr size_t WRITE_CHUNK_POINTS = 4096;
+
+constexpr size_t BBERG_FIELD_WORDS = sizeof(bb::fq::field_t) / sizeof(uint64_t);
+
+// Decodes num_coordinates field elements from canonical big-endian limbs to Montgomery form.
+void decode_coordinates(bb::fq::field_t *coordinates, char const *buffer, size_t num_coordinates)
+{
+    field_conversion::byteswap_words(coordinates, buffer, num_coordinates * BBERG_FIELD_WORDS);
+    for (size_t i = 0; i < num_coordinates; ++i)
+    {
+        bb::fq::to_montgomery_form(coordinates[i], coordinates[i]);
+    }
+}
+
+void encode_coordinates(char *buffer, bb::fq::field_t const *coordinates, size_t num_coordinates)
+{
+    std::vector<bb::fq::field_t> canonical(num_coordinates);
+    for (size_t i = 0; i < num_coordinates; ++i)
+    {
+        bb::fq::from_montgomery_form(coordinates[i], canonical[i]);
+    }
+    field_conversion::byteswap_words(buffer, &canonical[0], num_coordinates * BBERG_FIELD_WORDS);
+}
+
+template <typename AffineT>
+void append_elements(std::vector<AffineT> &elements,
+                     char const *buffer,
+                     size_t size,
+                     void (*decode)(AffineT *, char const *, size_t))
+{
+    const size_t num = size / sizeof(AffineT);
+    const size_t start = elements.size();
+    if (num == 0)
+    {
+        return;
+    }
+    elements.resize(start + num);
+    decode(&elements[start], buffer, num);
+}
+
+template <typename AffineT>
+void write_elements(TranscriptWriter &writer,
+                    std::vector<AffineT> const &elements,
+                    void (*encode)(AffineT const *, size_t, char *))
+{
+    std::vector<char> chunk(sizeof(AffineT) * std::min(WRITE_CHUNK_POINTS, elements.size()));
+    for (size_t i = 0; i < elements.size(); i += WRITE_CHUNK_POINTS)
+    {
+        size_t num = std::min(WRITE_CHUNK_POINTS, elements.size() - i);
+        encode(&elements[i], num, &chunk[0]);
+        writer.write(&chunk[0], num * sizeof(AffineT));
+    }
+}
+
+} // namespace
+
+void read_bberg_g1_elements_from_buffer(bb::g1::affine_element *elements, char const *buffer, size_t num_elements)
+{
+    decode_coordinates(&elements[0].x, buffer, 2 * num_elements);
+    for (size_t i = 0; i < num_elements; ++i)
+    {
+        if (!bb::g1::on_curve(elements[i]) || bb::g1::is_point_at_infinity(elements[i]))
+        {
+            throw std::runtime_error("G1 points are not on the curve!");
+        }
+    }
+}
+
+void read_bberg_g2_elements_from_buffer(bb::g2::affine_element *elements, char const *buffer, size_t num_elements)
+{
+    decode_coordinates(&elements[0].x.c0, buffer, 4 * num_elements);
+    for (size_t i = 0; i < num_elements; ++i)
+    {
+        if (!bb::g2::on_curve(elements[i]))
+        {
+            throw std::runtime_error("G2 points are not on the curve!");
+        }
+    }
+}
+
+void write_bberg_g1_elements_to_buffer(bb::g1::affine_element const *elements, size_t num_elements, char *buffer)
+{
+    encode_coordinates(buffer, &elements[0].x, 2 * num_elements);
+}
+
+void write_bberg_g2_elements_to_buffer(bb::g2::affine_element const *elements, size_t num_elements, char *buffer)
+{
+    encode_coordinates(buffer, &elements[0].x.c0, 4 * num_elements);
+}
+
+void read_transcript_bberg(std::vector<bb::g1::affine_element> &g1_x,
+                           std::vector<bb::g2::affine_element> &g2_x,
+                           Manifest &manifest,
+                           std::string const &path)
+{
+    read_transcript_manifest(manifest, path);
+    g1_x.reserve(g1_x.size() + manifest.num_g1_points);
+    g2_x.reserve(g2_x.size() + manifest.num_g2_points);
+
+    stream_transcript(
+        path,
+        manifest,
+        [&](char const *data, size_t size) { append_elements(g1_x, data, size, read_bberg_g1_elements_from_buffer); },
+        [&](char const *data, size_t size) { append_elements(g2_x, data, size, read_bberg_g2_elements_from_buffer); });
+}
+
+void read_transcript_bberg_g1_points(std::vector<bb::g1::affine_element> &g1_x, std::string const &path, int offset, size_t num)
+{
+    Manifest manifest;
+    read_transcript_manifest(manifest, path);
+
+    offset = offset < 0 ? manifest.num_g1_points + offset : offset;
+
+    if ((uint32_t)offset < manifest.num_g1_points)
+    {
+        num = std::min((size_t)manifest.num_g1_points - offset, num);
+        g1_x.reserve(g1_x.size() + num);
+        stream_transcript_points(path, sizeof(Manifest) + (BBERG_G1_BYTES * offset), BBERG_G1_BYTES * num, [&](char const *data, size_t size) {
+            append_elements(g1_x, data, size, read_bberg_g1_elements_from_buffer);
+        });
+    }
+}
+
+void read_transcript_bberg_g2_points(std::vector<bb::g2::affine_element> &g2_x, std::string const &path, int offset, size_t num)
+{
+    Manifest manifest;
+    read_transcript_manifest(manifest, path);
+
+    offset = offset < 0 ? manifest.num_g2_points + offset : offset;
+
+    if ((uint32_t)offset < manifest.num_g2_points)
+    {
+        num = std::min((size_t)manifest.num_g2_points - offset, num);
+        g2_x.reserve(g2_x.size() + num);
+        const size_t g2_start = sizeof(Manifest) + (BBERG_G1_BYTES * manifest.num_g1_points);
+        stream_transcript_points(path, g2_start + (BBERG_G2_BYTES * offset), BBERG_G2_BYTES * num, [&](char const *data, size_t size) {
+            append_elements(g2_x, data, size, read_bberg_g2_elements_from_buffer);
+        });
+    }
+}
+
+void load_transcripts_bberg_g1_points(TranscriptSet const &set,
+                                      size_t first,
+                                      size_t count,
+                                      bb::g1::affine_element *g1_x,
+                                      size_t read_ahead)
+{
+    const size_t base = set.g1_offsets[first];
+    stream_transcripts(
+        set,
+        first,
+        count,
+        [&](size_t, size_t point_index, char const *data, size_t size) {
+            read_bberg_g1_elements_from_buffer(&g1_x[point_index - base], data, size / BBERG_G1_BYTES);
+        },
+        [](size_t, size_t, char const *, size_t) {},
+        read_ahead);
+}
+
+void write_transcript_bberg(std::vector<bb::g1::affine_element> const &g1_x,
+                            std::vector<bb::g2::affine_element> const &g2_x,
+                            Manifest const &manifest,
+                            std::string const &path)
+{
+    TranscriptWriter writer(path);
+    write_transcript_manifest(writer, manifest);
+    write_elements(writer, g1_x, write_bberg_g1_elements_to_buffer);
+    write_elements(writer, g2_x, write_bberg_g2_elements_to_buffer);
+    writer.finish();
+}
+
+} // namespace streaming
@@ -0,0 +1,51 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "streaming_transcript.hpp"
+#include "transcript_set.hpp"
+#include <barretenberg/fields/fq.hpp>
+#include <barretenberg/fields/fq2.hpp>
+#include <barretenberg/groups/g1.hpp>
+#include <barretenberg/groups/g2.hpp>
+
+// Transcript readers and writers that work directly on barretenberg affine points in Montgomery form.
+// The on-disk format is identical to the libff readers', but no element passes through libff or GMP.
+namespace streaming
+{
+namespace bb = barretenberg;
+
+constexpr size_t BBERG_G1_BYTES = 2 * sizeof(bb::fq::field_t);
+constexpr size_t BBERG_G2_BYTES = 4 * sizeof(bb::fq::field_t);
+
+void read_bberg_g1_elements_from_buffer(bb::g1::affine_element *elements, char const *buffer, size_t num_elements);
+
+void read_bberg_g2_elements_from_buffer(bb::g2::affine_element *elements, char const *buffer, size_t num_elements);
+
+void write_bberg_g1_elements_to_buffer(bb::g1::affine_element const *elements, size_t num_elements, char *buffer);
+
+void write_bberg_g2_elements_to_buffer(bb::g2::affine_element const *elements, size_t num_elements, char *buffer);
+
+void read_transcript_bberg(std::vector<bb::g1::affine_element> &g1_x,
+                           std::vector<bb::g2::affine_element> &g2_x,
+                           Manifest &manifest,
+                           std::string const &path);
+
+void read_transcript_bberg_g1_points(std::vector<bb::g1::affine_element> &g1_x, std::string const &path, int offset, size_t num);
+
+void read_transcript_bberg_g2_points(std::vector<bb::g2::affine_element> &g2_x, std::string const &path, int offset, size_t num);
+
+// Loads the G1 points of count transcripts starting from first into g1_x, which must have room for them all.
+void load_transcripts_bberg_g1_points(TranscriptSet const &set,
+                                      size_t first,
+                                      size_t count,
+                                      bb::g1::affine_element *g1_x,
+                                      size_t read_ahead = DEFAULT_READ_AHEAD);
+
+void write_transcript_bberg(std::vector<bb::g1::affine_element> const &g1_x,
+                            std::vector<bb::g2::affine_element> const &g2_x,
+                            Manifest const &manifest,
+                            std::string const &path);
+
+} // namespace streaming
@@ -1,6 +1,7 @@
 #include "streaming_g1.hpp"
 #include "streaming.hpp"
 #include "compression.hpp"
+#include "field_conversion.hpp"
 
 namespace streaming
 {
@@ -23,18 +24,47 @@ void write_g1_element_to_buffer(G1 const &element, char *buffer)
     }
 }
 
-void write_g1_elements_to_buffer(std::vector<G1> const &elements, char *buffer)
+namespace
+{
+
+// Number of points converted per batch, bounding the size of the coordinate scratch space.
+constexpr size_t CONVERSION_BATCH_SIZE = 1024;
+
+} // namespace
+
+void write_g1_elements_to_buffer(G1 const *elements, size_t num_elements, char *buffer)
 {
     constexpr size_t bytes_per_element = USE_COMPRESSION ? sizeof(Fq) : sizeof(Fq) * 2;
 
-    for (size_t i = 0; i < elements.size(); ++i)
+    if (USE_COMPRESSION)
     {
-        size_t byte_position = bytes_per_element * i;
-        write_g1_element_to_buffer(elements[i], buffer + byte_position);
+        for (size_t i = 0; i < num_elements; ++i)
+        {
+            size_t byte_position = bytes_per_element * i;
+            write_g1_element_to_buffer(elements[i], buffer + byte_position);
+        }
+        return;
     }
+
+    std::vector<Fq> coordinates(2 * std::min(num_elements, CONVERSION_BATCH_SIZE));
+    for (size_t start = 0; start < num_elements; start += CONVERSION_BATCH_SIZE)
+    {
+        size_t num = std::min(CONVERSION_BATCH_SIZE, num_elements - start);
+        for (size_t i = 0; i < num; ++i)
+        {
+            coordinates[2 * i] = elements[start + i].X;
+            coordinates[2 * i + 1] = elements[start + i].Y;
+        }
+        field_conversion::encode_field_elements(buffer + start * bytes_per_element, &coordinates[0], 2 * num);
+    }
+}
+
+void write_g1_elements_to_buffer(std::vector<G1> const &elements, char *buffer)
+{
+    write_g1_elements_to_buffer(elements.data(), elements.size(), buffer);
 }
 
-G1 read_g1_element_from_buffer(char *buffer)
+G1 read_g1_element_from_buffer(char const *buffer)
 {
     constexpr size_t num_limbs = sizeof(Fq) / GMP_NUMB_BYTES;
 
@@ -73,16 +103,48 @@ G1 read_g1_element_from_buffer(char *buffer)
     return element;
 }
 
-void read_g1_elements_from_buffer(std::vector<G1> &elements, char *buffer, size_t buffer_size)
+void read_g1_elements_from_buffer(G1 *elements, char const *buffer, size_t num_elements, bool check_points)
 {
     constexpr size_t bytes_per_element = USE_COMPRESSION ? sizeof(Fq) : sizeof(Fq) * 2;
-    size_t num_elements = buffer_size / bytes_per_element;
-    elements.reserve(elements.size() + num_elements);
 
-    for (size_t i = 0; i < num_elements; ++i)
+    if (USE_COMPRESSION)
     {
-        elements.push_back(read_g1_element_from_buffer(&buffer[i * bytes_per_element]));
+        for (size_t i = 0; i < num_elements; ++i)
+        {
+            elements[i] = read_g1_element_from_buffer(&buffer[i * bytes_per_element]);
+        }
+        return;
+    }
+
+    std::vector<Fq> coordinates(2 * std::min(num_elements, CONVERSION_BATCH_SIZE));
+    for (size_t start = 0; start < num_elements; start += CONVERSION_BATCH_SIZE)
+    {
+        size_t num = std::min(CONVERSION_BATCH_SIZE, num_elements - start);
+        field_conversion::decode_field_elements(&coordinates[0], buffer + start * bytes_per_element, 2 * num);
+        for (size_t i = 0; i < num; ++i)
+        {
+            G1 element(coordinates[2 * i], coordinates[2 * i + 1], Fq::one());
+            if (check_points && !element.is_well_formed())
+            {
+                throw std::runtime_error("G1 points are not on the curve!");
+            }
+            elements[start + i] = element;
+        }
     }
 }
 
+void read_g1_elements_from_buffer(std::vector<G1> &elements, char const *buffer, size_t buffer_size)
+{
+    constexpr size_t bytes_per_element = USE_COMPRESSION ? sizeof(Fq) : sizeof(Fq) * 2;
+    size_t num_elements = buffer_size / bytes_per_element;
+    if (num_elements == 0)
+    {
+        return;
+    }
+
+    size_t start = elements.size();
+    elements.resize(start + num_elements);
+    read_g1_elements_from_buffer(&elements[start], buffer, num_elements);
+}
+
 } // namespace streaming
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "streaming_g2.hpp"
 #include "streaming.hpp"
+#include "field_conversion.hpp"
 
 namespace streaming
 {
@@ -28,18 +29,49 @@ void write_g2_element_to_buffer(G2 const &element, char *buffer)
     }
 }
 
-void write_g2_elements_to_buffer(std::vector<G2> const &elements, char *buffer)
+namespace
+{
+
+// Number of points converted per batch, bounding the size of the coordinate scratch space.
+constexpr size_t CONVERSION_BATCH_SIZE = 1024;
+
+} // namespace
+
+void write_g2_elements_to_buffer(G2 const *elements, size_t num_elements, char *buffer)
 {
     constexpr size_t bytes_per_element = USE_COMPRESSION ? sizeof(Fqe) : sizeof(Fqe) * 2;
 
-    for (size_t i = 0; i < elements.size(); ++i)
+    if (USE_COMPRESSION)
     {
-        size_t byte_position = bytes_per_element * i;
-        write_g2_element_to_buffer(elements[i], buffer + byte_position);
+        for (size_t i = 0; i < num_elements; ++i)
+        {
+            size_t byte_position = bytes_per_element * i;
+            write_g2_element_to_buffer(elements[i], buffer + byte_position);
+        }
+        return;
     }
+
+    std::vector<Fq> coordinates(4 * std::min(num_elements, CONVERSION_BATCH_SIZE));
+    for (size_t start = 0; start < num_elements; start += CONVERSION_BATCH_SIZE)
+    {
+        size_t num = std::min(CONVERSION_BATCH_SIZE, num_elements - start);
+        for (size_t i = 0; i < num; ++i)
+        {
+            coordinates[4 * i] = elements[start + i].X.c0;
+            coordinates[4 * i + 1] = elements[start + i].X.c1;
+            coordinates[4 * i + 2] = elements[start + i].Y.c0;
+            coordinates[4 * i + 3] = elements[start + i].Y.c1;
+        }
+        field_conversion::encode_field_elements(buffer + start * bytes_per_element, &coordinates[0], 4 * num);
+    }
+}
+
+void write_g2_elements_to_buffer(std::vector<G2> const &elements, char *buffer)
+{
+    write_g2_elements_to_buffer(elements.data(), elements.size(), buffer);
 }
 
-G2 read_g2_element_from_buffer(char *buffer)
+G2 read_g2_element_from_buffer(char const *buffer)
 {
     constexpr size_t num_limbs = sizeof(Fq) / GMP_NUMB_BYTES;
     G2 element;
@@ -86,17 +118,48 @@ G2 read_g2_element_from_buffer(char *buffer)
     return element;
 }
 
-void read_g2_elements_from_buffer(std::vector<G2> &elements, char *buffer, size_t buffer_size)
+void read_g2_elements_from_buffer(G2 *elements, char const *buffer, size_t num_elements, bool check_points)
 {
     constexpr size_t bytes_per_element = USE_COMPRESSION ? sizeof(Fqe) : sizeof(Fqe) * 2;
-    size_t num_elements = buffer_size / bytes_per_element;
 
-    elements.reserve(elements.size() + num_elements);
+    if (USE_COMPRESSION)
+    {
+        for (size_t i = 0; i < num_elements; ++i)
+        {
+            elements[i] = read_g2_element_from_buffer(&buffer[i * bytes_per_element]);
+        }
+        return;
+    }
+
+    std::vector<Fq> coordinates(4 * std::min(num_elements, CONVERSION_BATCH_SIZE));
+    for (size_t start = 0; start < num_elements; start += CONVERSION_BATCH_SIZE)
+    {
+        size_t num = std::min(CONVERSION_BATCH_SIZE, num_elements - start);
+        field_conversion::decode_field_elements(&coordinates[0], buffer + start * bytes_per_element, 4 * num);
+        for (size_t i = 0; i < num; ++i)
+        {
+            G2 element(Fqe(coordinates[4 * i], coordinates[4 * i + 1]), Fqe(coordinates[4 * i + 2], coordinates[4 * i + 3]), Fqe::one());
+            if (check_points && !element.is_well_formed())
+            {
+                throw std::runtime_error("G2 points are not on the curve!");
+            }
+            elements[start + i] = element;
+        }
+    }
+}
 
-    for (size_t i = 0; i < num_elements; ++i)
+void read_g2_elements_from_buffer(std::vector<G2> &elements, char const *buffer, size_t buffer_size)
+{
+    constexpr size_t bytes_per_element = USE_COMPRESSION ? sizeof(Fqe) : sizeof(Fqe) * 2;
+    size_t num_elements = buffer_size / bytes_per_element;
+    if (num_elements == 0)
     {
-        elements.push_back(read_g2_element_from_buffer(&buffer[i * bytes_per_element]));
+        return;
     }
+
+    size_t start = elements.size();
+    elements.resize(start + num_elements);
+    read_g2_elements_from_buffer(&elements[start], buffer, num_elements);
 }
 
 } // namespace streaming
\ No newline at end of file
@@ -6,8 +6,14 @@ namespace streaming
 
 void write_g2_element_to_buffer(G2 &element, char *buffer);
 
-void read_g2_elements_from_buffer(std::vector<G2> &elements, char *buffer, size_t buffer_size);
+void read_g2_elements_from_buffer(std::vector<G2> &elements, char const *buffer, size_t buffer_size);
+
+// Decodes num_elements points into a presized destination. Each point is checked to be on the curve unless
+// check_points is false, which is only safe for data that is already known to be valid.
+void read_g2_elements_from_buffer(G2 *elements, char const *buffer, size_t num_elements, bool check_points = true);
 
 void write_g2_elements_to_buffer(std::vector<G2> const &elements, char *buffer);
 
+void write_g2_elements_to_buffer(G2 const *elements, size_t num_elements, char *buffer);
+
 }
\ No newline at end of file
@@ -1,19 +1,21 @@
 #pragma once
 #include "./streaming.hpp"
 #include "./streaming_g1.hpp"
+#include "./async_io.hpp"
 #include <barretenberg/fields/fr.hpp>
 #include <barretenberg/fields/fq.hpp>
 #include <barretenberg/groups/g1.hpp>
 
 #include "omp.h"
 
+// Points per range point file, as compute_range_polynomial --all writes them and read_file reads them back.
 constexpr size_t POINTS_PER_RANGE_FILE = 1000;
 constexpr size_t MAX_RANGE = 10000000;
 namespace streaming
 {
 namespace bb = barretenberg;
 
-bb::g1::affine_element decompress(const bb::fq::field_t& x_in)
+inline bb::g1::affine_element decompress(const bb::fq::field_t& x_in)
 {
     bb::fq::field_t uncompressed = x_in;
     bool y_bit_flag = (uncompressed.data[3] >> 63ULL) == 1ULL;
@@ -44,7 +46,7 @@ bb::g1::affine_element decompress(const bb::fq::field_t& x_in)
     return result;
 }
 
-bb::g1::affine_element read_bberg_element_from_buffer(char *buffer)
+inline bb::g1::affine_element read_bberg_element_from_buffer(char const *buffer)
 {
     bb::fq::field_t x;
     bb::fq::field_t x_buf;
@@ -74,7 +76,7 @@ bb::g1::affine_element read_bberg_element_from_buffer(char *buffer)
     return element;
 }
 
-void read_bberg_elements_to_file(bb::g1::affine_element* elements, char *buffer, size_t buffer_size, bool force_compression)
+inline void read_bberg_elements_to_file(bb::g1::affine_element* elements, char const *buffer, size_t buffer_size, bool force_compression)
 {
     const size_t bytes_per_element = sizeof(bb::fq::field_t);
     size_t num_elements = buffer_size / bytes_per_element;
@@ -85,7 +87,7 @@ void read_bberg_elements_to_file(bb::g1::affine_element* elements, char *buffer,
     }
 }
 
-void read_file(std::string range_path, std::vector<bb::g1::affine_element>& points)
+inline void read_file(std::string range_path, std::vector<bb::g1::affine_element>& points)
 {
     constexpr size_t num_files = (MAX_RANGE / POINTS_PER_RANGE_FILE) + 1;
     const size_t num_threads = omp_get_max_threads();
@@ -100,22 +102,28 @@ void read_file(std::string range_path, std::vector<bb::g1::affine_element>& poin
         {
             end += leftovers;
         }
+        std::vector<ReadRequest> requests;
         for (size_t i = start; i < end; ++i)
         {
-            if ((i % 100) == 0)
-            {
-                printf("i = %lu \n", i);
-            }
             size_t g1_buffer_size = 32 * POINTS_PER_RANGE_FILE;
             if (i == num_files - 1)
             {
                 g1_buffer_size = 32; // only 1 point here
             }
             std::string filename = range_path + "data" + std::to_string(i * POINTS_PER_RANGE_FILE) + ".dat";
-
-            auto buffer = read_file_into_buffer(filename);
-            read_bberg_elements_to_file(&points[i * POINTS_PER_RANGE_FILE], &buffer[0], g1_buffer_size, true);
+            requests.push_back({ filename, 0, g1_buffer_size });
         }
+
+        // Keep this thread's files streaming in while earlier ones are decompressed.
+        auto io = create_async_io(DEFAULT_QUEUE_DEPTH, 32 * POINTS_PER_RANGE_FILE);
+        io->read(requests, [&](size_t request, size_t request_offset, char const *data, size_t size) {
+            size_t i = start + request;
+            if ((i % 100) == 0 && request_offset == 0)
+            {
+                printf("i = %lu \n", i);
+            }
+            read_bberg_elements_to_file(&points[i * POINTS_PER_RANGE_FILE + request_offset / 32], data, size, true);
+        });
     }
 }
 }
@@ -2,8 +2,18 @@
 #include "streaming.hpp"
 #include "streaming_g1.hpp"
 #include "streaming_g2.hpp"
+#include "transcript_writer.hpp"
+#include "async_io.hpp"
+#include "transcript_set.hpp"
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <thread>
 #include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace streaming
 {
@@ -29,25 +39,287 @@ void read_manifest(std::vector<char> &buffer, Manifest &manifest)
   manifest.start_from = ntohl(manifest.start_from);
 }
 
-std::vector<char> read_checksum(std::string const &path)
+namespace
+{
+
+enum TranscriptRegion
+{
+  MANIFEST_REGION,
+  G1_REGION,
+  G2_REGION,
+  CHECKSUM_REGION,
+};
+
+// A loader sized to the reads at hand. Reading a few boundary points, as verifiers do from many threads, then sets up
+// a buffer or two rather than a full queue of them (and, without io_uring, as many threads), and nothing is kept
+// once the reads are done. A whole transcript still gets the full queue, whose setup is small next to the read.
+std::unique_ptr<AsyncIo> transcript_io(std::vector<ReadRequest> const &requests)
 {
-  auto buffer = read_file_into_buffer(path);
-  std::vector<char> checksum = validate_checksum(buffer);
-  return checksum;
+  size_t largest = 0;
+  for (auto const &request : requests)
+  {
+    largest = std::max(largest, request.size);
+  }
+  const size_t buffer_size = std::max((size_t)1, std::min(DEFAULT_IO_BUFFER_SIZE, largest));
+
+  size_t num_chunks = 0;
+  for (auto const &request : requests)
+  {
+    num_chunks += (request.size + buffer_size - 1) / buffer_size;
+  }
+  return create_async_io(std::max((size_t)1, std::min(DEFAULT_QUEUE_DEPTH, num_chunks)), buffer_size);
 }
 
-void read_transcript(std::vector<G1> &g1_x, std::vector<G2> &g2_x, Manifest &manifest, std::string const &path)
+// Number of points serialized at a time when streaming a transcript to disk.
+constexpr size_t WRITE_CHUNK_POINTS = 4096;
+
+template <typename GroupT, typename FieldT>
+void write_elements(TranscriptWriter &writer, std::vector<GroupT> const &elements, void (*serialize)(GroupT const *, size_t, char *))
 {
-  auto buffer = read_file_into_buffer(path);
-  validate_checksum(buffer);
-  read_manifest(buffer, manifest);
+  constexpr size_t bytes_per_element = sizeof(FieldT) * (USE_COMPRESSION ? 1 : 2);
+  std::vector<char> chunk(bytes_per_element * std::min(WRITE_CHUNK_POINTS, elements.size()));
+  for (size_t i = 0; i < elements.size(); i += WRITE_CHUNK_POINTS)
+  {
+    size_t num = std::min(WRITE_CHUNK_POINTS, elements.size() - i);
+    serialize(&elements[i], num, &chunk[0]);
+    writer.write(&chunk[0], num * bytes_per_element);
+  }
+}
+
+// How long a FollowReader waits before looking again for data past the end of a growing file.
+constexpr size_t FOLLOW_POLL_MILLISECONDS = 50;
+
+// Reads a file that may still be growing, or a pipe, waiting for data that hasn't arrived yet rather than stopping
+// at the end.
+class FollowReader
+{
+public:
+  FollowReader(std::string const &path, size_t timeout_seconds)
+      : path_(path), fd_(-1), offset_(0), timeout_(std::chrono::seconds(timeout_seconds)), last_data_(std::chrono::steady_clock::now())
+  {
+    if (path == "-")
+    {
+      fd_ = STDIN_FILENO;
+    }
+    // The file may not have been created yet.
+    while (fd_ < 0)
+    {
+      fd_ = open(path.c_str(), O_RDONLY);
+      if (fd_ < 0)
+      {
+        if (errno != ENOENT)
+        {
+          throw std::runtime_error("Failed to open transcript: " + path);
+        }
+        wait("Transcript not found: " + path);
+      }
+    }
+    struct stat st;
+    regular_ = fstat(fd_, &st) == 0 && S_ISREG(st.st_mode);
+  }
+
+  ~FollowReader()
+  {
+    if (fd_ != STDIN_FILENO)
+    {
+      close(fd_);
+    }
+  }
+
+  // Fills buffer with the next size bytes, waiting for them to be written.
+  void read(char *buffer, size_t size)
+  {
+    while (size)
+    {
+      ssize_t num = ::read(fd_, buffer, size);
+      if (num < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        throw std::runtime_error("Failed to read transcript: " + path_);
+      }
+      if (num > 0)
+      {
+        buffer += num;
+        size -= num;
+        offset_ += num;
+        last_data_ = std::chrono::steady_clock::now();
+        continue;
+      }
+      // A pipe has no more data once its writer closes it, but a file can still grow.
+      if (!regular_)
+      {
+        throw std::runtime_error("Transcript ended early: " + path_);
+      }
+      wait("Timed out waiting for transcript data: " + path_);
+    }
+  }
+
+  // Whether a file holds nothing past what has been read. Anything written to a pipe later is not checked.
+  bool at_end() const
+  {
+    struct stat st;
+    return !regular_ || (fstat(fd_, &st) == 0 && (size_t)st.st_size == offset_);
+  }
+
+private:
+  FollowReader(const FollowReader &);
+  FollowReader &operator=(const FollowReader &);
+
+  void wait(std::string const &error)
+  {
+    if (std::chrono::steady_clock::now() - last_data_ > timeout_)
+    {
+      throw std::runtime_error(error);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_POLL_MILLISECONDS));
+  }
+
+  std::string path_;
+  int fd_;
+  bool regular_;
+  size_t offset_;
+  std::chrono::steady_clock::duration timeout_;
+  std::chrono::steady_clock::time_point last_data_;
+};
+
+} // namespace
+
+std::vector<char> stream_transcript(std::string const &path, Manifest &manifest, ChunkDecoder const &on_g1, ChunkDecoder const &on_g2)
+{
+  read_transcript_manifest(manifest, path);
 
   const size_t manifest_size = sizeof(Manifest);
   const size_t g1_buffer_size = sizeof(Fq) * (USE_COMPRESSION ? 1 : 2) * manifest.num_g1_points;
   const size_t g2_buffer_size = sizeof(Fqe) * (USE_COMPRESSION ? 1 : 2) * manifest.num_g2_points;
+  const size_t transcript_size = get_transcript_size(manifest);
+  if (get_file_size(path) != transcript_size)
+  {
+    throw std::runtime_error("Transcript size does not match manifest: " + path);
+  }
+
+  std::vector<ReadRequest> requests = {
+      {path, 0, manifest_size},
+      {path, manifest_size, g1_buffer_size},
+      {path, manifest_size + g1_buffer_size, g2_buffer_size},
+      {path, transcript_size - checksum::BLAKE2B_CHECKSUM_LENGTH, checksum::BLAKE2B_CHECKSUM_LENGTH},
+  };
+
+  blake2b_state state;
+  blake2b_init(&state, checksum::BLAKE2B_CHECKSUM_LENGTH);
+  std::vector<char> manifest_buffer;
+  std::vector<char> expected;
 
-  read_g1_elements_from_buffer(g1_x, &buffer[manifest_size], g1_buffer_size);
-  read_g2_elements_from_buffer(g2_x, &buffer[manifest_size + g1_buffer_size], g2_buffer_size);
+  transcript_io(requests)->read(requests, [&](size_t request, size_t, char const *data, size_t size) {
+    if (request != CHECKSUM_REGION)
+    {
+      blake2b_update(&state, data, size);
+    }
+    switch (request)
+    {
+    case MANIFEST_REGION:
+      manifest_buffer.insert(manifest_buffer.end(), data, data + size);
+      break;
+    case G1_REGION:
+      on_g1(data, size);
+      break;
+    case G2_REGION:
+      on_g2(data, size);
+      break;
+    default:
+      expected.insert(expected.end(), data, data + size);
+      break;
+    }
+  });
+
+  std::vector<char> digest(checksum::BLAKE2B_CHECKSUM_LENGTH);
+  blake2b_final(&state, &digest[0], checksum::BLAKE2B_CHECKSUM_LENGTH);
+  if (digest != expected)
+  {
+    throw std::runtime_error("Checksum failed.");
+  }
+
+  // Take the manifest from the bytes that were hashed.
+  read_manifest(manifest_buffer, manifest);
+  return digest;
+}
+
+std::vector<char> follow_transcript(std::string const &path,
+                                    Manifest &manifest,
+                                    ManifestCallback const &on_manifest,
+                                    ChunkDecoder const &on_g1,
+                                    ChunkDecoder const &on_g2,
+                                    size_t timeout_seconds)
+{
+  FollowReader reader(path, timeout_seconds);
+  blake2b_state state;
+  blake2b_init(&state, checksum::BLAKE2B_CHECKSUM_LENGTH);
+
+  std::vector<char> buffer(sizeof(Manifest));
+  reader.read(&buffer[0], buffer.size());
+  blake2b_update(&state, &buffer[0], buffer.size());
+  read_manifest(buffer, manifest);
+  on_manifest(manifest);
+
+  // Each region is read a buffer of whole points at a time.
+  buffer.resize(DEFAULT_IO_BUFFER_SIZE);
+  auto follow_region = [&](size_t num_points, size_t point_size, ChunkDecoder const &decode) {
+    const size_t points_per_chunk = buffer.size() / point_size;
+    for (size_t i = 0; i < num_points; i += points_per_chunk)
+    {
+      const size_t size = std::min(points_per_chunk, num_points - i) * point_size;
+      reader.read(&buffer[0], size);
+      blake2b_update(&state, &buffer[0], size);
+      decode(&buffer[0], size);
+    }
+  };
+  follow_region(manifest.num_g1_points, sizeof(Fq) * (USE_COMPRESSION ? 1 : 2), on_g1);
+  follow_region(manifest.num_g2_points, sizeof(Fqe) * (USE_COMPRESSION ? 1 : 2), on_g2);
+
+  std::vector<char> expected(checksum::BLAKE2B_CHECKSUM_LENGTH);
+  reader.read(&expected[0], expected.size());
+  if (!reader.at_end())
+  {
+    throw std::runtime_error("Transcript size does not match manifest: " + path);
+  }
+
+  std::vector<char> digest(checksum::BLAKE2B_CHECKSUM_LENGTH);
+  blake2b_final(&state, &digest[0], checksum::BLAKE2B_CHECKSUM_LENGTH);
+  if (digest != expected)
+  {
+    throw std::runtime_error("Checksum failed.");
+  }
+  return digest;
+}
+
+void stream_transcript_points(std::string const &path, size_t offset, size_t size, ChunkDecoder const &decode)
+{
+  std::vector<ReadRequest> requests = {{path, offset, size}};
+  transcript_io(requests)->read(requests, [&](size_t, size_t, char const *data, size_t chunk_size) {
+    decode(data, chunk_size);
+  });
+}
+
+std::vector<char> read_checksum(std::string const &path)
+{
+  Manifest manifest;
+  auto skip = [](char const *, size_t) {};
+  return stream_transcript(path, manifest, skip, skip);
+}
+
+void read_transcript(std::vector<G1> &g1_x, std::vector<G2> &g2_x, Manifest &manifest, std::string const &path)
+{
+  read_transcript_manifest(manifest, path);
+  g1_x.reserve(g1_x.size() + manifest.num_g1_points);
+  g2_x.reserve(g2_x.size() + manifest.num_g2_points);
+
+  stream_transcript(
+      path,
+      manifest,
+      [&](char const *data, size_t size) { read_g1_elements_from_buffer(g1_x, data, size); },
+      [&](char const *data, size_t size) { read_g2_elements_from_buffer(g2_x, data, size); });
 }
 
 void read_transcript_manifest(Manifest &manifest, std::string const &path)
@@ -69,8 +341,10 @@ void read_transcript_g1_points(std::vector<G1> &g1_x, std::string const &path, i
   if ((uint32_t)offset < manifest.num_g1_points)
   {
     num = std::min((size_t)manifest.num_g1_points - offset, num);
-    auto g1_0_buffer = read_file_into_buffer(path, manifest_size + (g1_size * offset), g1_size * num);
-    read_g1_elements_from_buffer(g1_x, &g1_0_buffer[0], g1_size * num);
+    g1_x.reserve(g1_x.size() + num);
+    stream_transcript_points(path, manifest_size + (g1_size * offset), g1_size * num, [&](char const *data, size_t size) {
+      read_g1_elements_from_buffer(g1_x, data, size);
+    });
   }
 }
 
@@ -88,19 +362,15 @@ void read_transcript_g2_points(std::vector<G2> &g2_x, std::string const &path, i
   if ((uint32_t)offset < manifest.num_g2_points)
   {
     num = std::min((size_t)manifest.num_g2_points - offset, num);
-    auto g2_0_buffer = read_file_into_buffer(path, manifest_size + (g1_size * manifest.num_g1_points) + (g2_size * offset), g2_size * num);
-    read_g2_elements_from_buffer(g2_x, &g2_0_buffer[0], g2_size * num);
+    g2_x.reserve(g2_x.size() + num);
+    stream_transcript_points(path, manifest_size + (g1_size * manifest.num_g1_points) + (g2_size * offset), g2_size * num, [&](char const *data, size_t size) {
+      read_g2_elements_from_buffer(g2_x, data, size);
+    });
   }
 }
 
-void write_transcript(std::vector<G1> const &g1_x, std::vector<G2> const &g2_x, Manifest const &manifest, std::string const &path)
+void write_transcript_manifest(TranscriptWriter &writer, Manifest const &manifest)
 {
-  const size_t manifest_size = sizeof(Manifest);
-  const size_t g1_buffer_size = sizeof(Fq) * (USE_COMPRESSION ? 1 : 2) * g1_x.size();
-  const size_t g2_buffer_size = sizeof(Fqe) * (USE_COMPRESSION ? 1 : 2) * g2_x.size();
-  const size_t transcript_size = manifest_size + g1_buffer_size + g2_buffer_size + checksum::BLAKE2B_CHECKSUM_LENGTH;
-  std::vector<char> buffer(transcript_size);
-
   Manifest net_manifest;
   net_manifest.transcript_number = htonl(manifest.transcript_number);
   net_manifest.total_transcripts = htonl(manifest.total_transcripts);
@@ -109,13 +379,16 @@ void write_transcript(std::vector<G1> const &g1_x, std::vector<G2> const &g2_x,
   net_manifest.num_g1_points = htonl(manifest.num_g1_points);
   net_manifest.num_g2_points = htonl(manifest.num_g2_points);
   net_manifest.start_from = htonl(manifest.start_from);
+  writer.write((char *)&net_manifest, sizeof(Manifest));
+}
 
-  std::copy(&net_manifest, &net_manifest + 1, (Manifest *)&buffer[0]);
-
-  write_g1_elements_to_buffer(g1_x, &buffer[manifest_size]);
-  write_g2_elements_to_buffer(g2_x, &buffer[manifest_size + g1_buffer_size]);
-  add_checksum_to_buffer(&buffer[0], manifest_size + g1_buffer_size + g2_buffer_size);
-  write_buffer_to_file(path, buffer);
+void write_transcript(std::vector<G1> const &g1_x, std::vector<G2> const &g2_x, Manifest const &manifest, std::string const &path)
+{
+  TranscriptWriter writer(path);
+  write_transcript_manifest(writer, manifest);
+  write_elements<G1, Fq>(writer, g1_x, write_g1_elements_to_buffer);
+  write_elements<G2, Fqe>(writer, g2_x, write_g2_elements_to_buffer);
+  writer.finish();
 }
 
 std::string getTranscriptInPath(std::string const &dir, size_t num)
@@ -125,26 +398,7 @@ std::string getTranscriptInPath(std::string const &dir, size_t num)
 
 void read_transcripts_g1_points(std::vector<G1> &g1_x, std::string const &dir)
 {
-  streaming::Manifest manifest;
-
-  size_t num = 0;
-  std::string filename = getTranscriptInPath(dir, num);
-
-  // Reserve additional space to store all the points.
-  streaming::read_transcript_manifest(manifest, filename);
-  g1_x.reserve(g1_x.size() + manifest.total_g1_points);
-
-  while (streaming::is_file_exist(filename))
-  {
-    streaming::read_transcript_manifest(manifest, filename);
-    streaming::read_transcript_g1_points(g1_x, filename, 0, manifest.num_g1_points);
-    filename = getTranscriptInPath(dir, ++num);
-  }
-
-  if (num == 0)
-  {
-    throw std::runtime_error("No input files found.");
-  }
+  load_transcripts_g1_points(find_transcripts(dir), g1_x);
 }
 
 } // namespace streaming
\ No newline at end of file
@@ -1,11 +1,14 @@
 #pragma once
 #include "streaming.hpp"
+#include <functional>
 
 constexpr size_t POINTS_PER_TRANSCRIPT = 10000000;
 
 namespace streaming
 {
 
+class TranscriptWriter;
+
 struct Manifest
 {
   uint32_t transcript_number;
@@ -31,6 +34,35 @@ void read_transcript_g1_points(std::vector<G1> &g1_x, std::string const &path, i
 
 void read_transcript_g2_points(std::vector<G2> &g2_x, std::string const &path, int offset, size_t num);
 
+// Receives consecutive chunks of a point region. Every chunk holds a whole number of points.
+using ChunkDecoder = std::function<void(char const *, size_t)>;
+
+// Streams a whole transcript from disk, hashing each chunk as it arrives and handing the point regions to the
+// decoders, so decoding overlaps with the reads still in flight. Returns the validated checksum.
+std::vector<char> stream_transcript(std::string const &path, Manifest &manifest, ChunkDecoder const &on_g1, ChunkDecoder const &on_g2);
+
+// Idle time after which follow_transcript gives up on a transcript that has stopped arriving.
+constexpr size_t DEFAULT_FOLLOW_TIMEOUT_SECONDS = 60;
+
+// Called with a transcript's manifest as soon as it has been read, before any of its points. May throw to stop.
+using ManifestCallback = std::function<void(Manifest const &)>;
+
+// As stream_transcript, for a transcript that is still being written: path is a file that may still be growing,
+// or "-" for stdin. Points are handed on as they arrive, and the checksum is computed as the bytes do, so the
+// stream finishes moments after the last byte lands. Throws if the transcript stops arriving for timeout_seconds,
+// or stdin ends, before it is complete.
+std::vector<char> follow_transcript(std::string const &path,
+                                    Manifest &manifest,
+                                    ManifestCallback const &on_manifest,
+                                    ChunkDecoder const &on_g1,
+                                    ChunkDecoder const &on_g2,
+                                    size_t timeout_seconds = DEFAULT_FOLLOW_TIMEOUT_SECONDS);
+
+// Streams size bytes of point data starting at offset, without checksum validation.
+void stream_transcript_points(std::string const &path, size_t offset, size_t size, ChunkDecoder const &decode);
+
+void write_transcript_manifest(TranscriptWriter &writer, Manifest const &manifest);
+
 void write_transcript(std::vector<G1> const &g1_x, std::vector<G2> const &g2_x, Manifest const &manifest, std::string const &path);
 
 std::string getTranscriptInPath(std::string const &dir, size_t num);
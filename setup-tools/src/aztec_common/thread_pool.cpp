@@ -0,0 +1,172 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace parallel
+{
+
+struct ThreadPool::Loop
+{
+    Loop(size_t n, std::function<void(size_t)> const &fn)
+        : n(n)
+        , fn(fn)
+        , next(0)
+        , finished(0)
+    {
+    }
+
+    const size_t n;
+    std::function<void(size_t)> const &fn;
+    std::atomic<size_t> next;
+    size_t finished;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+namespace
+{
+
+// The CPUs this process may run on, so that a process pinned to some of them, by taskset say, doesn't oversubscribe.
+size_t available_threads()
+{
+#ifdef __linux__
+    cpu_set_t cpus;
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0 && CPU_COUNT(&cpus) > 0)
+    {
+        return CPU_COUNT(&cpus);
+    }
+#endif
+    const size_t num_threads = std::thread::hardware_concurrency();
+    return num_threads ? num_threads : 4;
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : stopping_(false)
+{
+    if (num_threads == 0)
+    {
+        num_threads = available_threads();
+    }
+    for (size_t i = 1; i < num_threads; ++i)
+    {
+        workers_.push_back(std::thread(&ThreadPool::work, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (size_t i = 0; i < workers_.size(); ++i)
+    {
+        workers_[i].join();
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, std::function<void(size_t)> const &fn)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    auto loop = std::make_shared<Loop>(n, fn);
+    if (n > 1 && !workers_.empty())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            loops_.push_back(loop);
+        }
+        cv_.notify_all();
+    }
+
+    run(*loop);
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->cv.wait(lock, [&] { return loop->finished == loop->n; });
+    if (loop->error)
+    {
+        std::rethrow_exception(loop->error);
+    }
+}
+
+// Claims and runs indices of the loop until none are left.
+void ThreadPool::run(Loop &loop)
+{
+    size_t completed = 0;
+    for (size_t i = loop.next++; i < loop.n; i = loop.next++)
+    {
+        try
+        {
+            loop.fn(i);
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> lock(loop.mutex);
+            if (!loop.error)
+            {
+                loop.error = std::current_exception();
+            }
+            // Skip whatever hasn't been claimed yet; those indices count as finished.
+            size_t claimed = loop.next.exchange(loop.n);
+            completed += claimed < loop.n ? loop.n - claimed : 0;
+        }
+        ++completed;
+    }
+
+    if (completed > 0)
+    {
+        std::unique_lock<std::mutex> lock(loop.mutex);
+        loop.finished += completed;
+        if (loop.finished == loop.n)
+        {
+            loop.cv.notify_all();
+        }
+    }
+}
+
+void ThreadPool::work()
+{
+    while (true)
+    {
+        std::shared_ptr<Loop> loop;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !loops_.empty() || stopping_; });
+            if (stopping_)
+            {
+                return;
+            }
+            loop = loops_.front();
+            if (loop->next >= loop->n)
+            {
+                // Every index has been claimed. The loop's owner waits for those still running.
+                loops_.pop_front();
+                continue;
+            }
+        }
+        run(*loop);
+    }
+}
+
+ThreadPool &default_thread_pool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace parallel
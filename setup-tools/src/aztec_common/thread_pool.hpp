@@ -0,0 +1,59 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel
+{
+
+// A fixed set of worker threads that cooperate on parallel_for loops.
+// The calling thread works through the loop too, so a loop started from inside another loop's body always makes
+// progress, even if every worker is busy, and nesting can't deadlock.
+class ThreadPool
+{
+  public:
+    // num_threads is the total parallelism including the caller; 0 means one per CPU the process may run on.
+    explicit ThreadPool(size_t num_threads = 0);
+
+    ~ThreadPool();
+
+    size_t size() const { return workers_.size() + 1; }
+
+    // Calls fn(i) for every i in [0, n), and returns once all calls have finished.
+    // If any call throws, remaining indices are skipped and the first exception is rethrown here.
+    void parallel_for(size_t n, std::function<void(size_t)> const &fn);
+
+  private:
+    struct Loop;
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    void work();
+    void run(Loop &loop);
+
+    bool stopping_;
+    std::vector<std::thread> workers_;
+    std::deque<std::shared_ptr<Loop>> loops_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+// Shared pool, created on first use with one thread per CPU the process may run on.
+ThreadPool &default_thread_pool();
+
+inline void parallel_for(size_t n, std::function<void(size_t)> const &fn)
+{
+    default_thread_pool().parallel_for(n, fn);
+}
+
+} // namespace parallel
@@ -0,0 +1,221 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "transcript_ledger.hpp"
+#include "streaming_g1.hpp"
+#include "streaming_g2.hpp"
+#include "thread_pool.hpp"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace streaming
+{
+
+namespace
+{
+
+constexpr size_t CHECKSUM_SIZE = checksum::BLAKE2B_CHECKSUM_LENGTH;
+
+// checksum, manifest, transcript 0 checksum, previous checksum, result, then the record's own checksum.
+constexpr size_t RECORD_DATA_SIZE = 3 * CHECKSUM_SIZE + sizeof(Manifest) + 1;
+constexpr size_t RECORD_SIZE = RECORD_DATA_SIZE + CHECKSUM_SIZE;
+
+constexpr size_t G1_BYTES = sizeof(Fq) * (USE_COMPRESSION ? 1 : 2);
+constexpr size_t G2_BYTES = sizeof(Fqe) * (USE_COMPRESSION ? 1 : 2);
+
+// Points checked per task when a transcript turns out not to be trusted.
+constexpr size_t CHECK_CHUNK_POINTS = 4096;
+
+void write_checksum_field(char *&out, std::vector<char> const &checksum)
+{
+    // A missing checksum is recorded as zeros.
+    memset(out, 0, CHECKSUM_SIZE);
+    if (!checksum.empty())
+    {
+        if (checksum.size() != CHECKSUM_SIZE)
+        {
+            throw std::runtime_error("Ledger checksums must be " + std::to_string(CHECKSUM_SIZE) + " bytes.");
+        }
+        memcpy(out, &checksum[0], CHECKSUM_SIZE);
+    }
+    out += CHECKSUM_SIZE;
+}
+
+std::vector<char> read_checksum_field(char const *&in)
+{
+    std::vector<char> checksum(in, in + CHECKSUM_SIZE);
+    in += CHECKSUM_SIZE;
+    if (std::all_of(checksum.begin(), checksum.end(), [](char c) { return c == 0; }))
+    {
+        checksum.clear();
+    }
+    return checksum;
+}
+
+std::vector<char> serialize_entry(LedgerEntry const &entry)
+{
+    std::vector<char> record(RECORD_SIZE);
+    char *out = &record[0];
+    write_checksum_field(out, entry.checksum);
+
+    Manifest manifest = entry.manifest;
+    manifest.transcript_number = htonl(manifest.transcript_number);
+    manifest.total_transcripts = htonl(manifest.total_transcripts);
+    manifest.total_g1_points = htonl(manifest.total_g1_points);
+    manifest.total_g2_points = htonl(manifest.total_g2_points);
+    manifest.num_g1_points = htonl(manifest.num_g1_points);
+    manifest.num_g2_points = htonl(manifest.num_g2_points);
+    manifest.start_from = htonl(manifest.start_from);
+    memcpy(out, &manifest, sizeof(Manifest));
+    out += sizeof(Manifest);
+
+    write_checksum_field(out, entry.transcript0_checksum);
+    write_checksum_field(out, entry.previous_checksum);
+    *out++ = entry.valid ? 1 : 0;
+    checksum::create_checksum(&record[0], RECORD_DATA_SIZE, out);
+    return record;
+}
+
+bool deserialize_entry(char const *record, LedgerEntry &entry)
+{
+    char record_checksum[CHECKSUM_SIZE];
+    checksum::create_checksum(record, RECORD_DATA_SIZE, record_checksum);
+    if (memcmp(record_checksum, record + RECORD_DATA_SIZE, CHECKSUM_SIZE) != 0)
+    {
+        return false;
+    }
+
+    char const *in = record;
+    entry.checksum = read_checksum_field(in);
+    std::vector<char> manifest_buffer(in, in + sizeof(Manifest));
+    read_manifest(manifest_buffer, entry.manifest);
+    in += sizeof(Manifest);
+    entry.transcript0_checksum = read_checksum_field(in);
+    entry.previous_checksum = read_checksum_field(in);
+    entry.valid = *in == 1;
+    return true;
+}
+
+template <typename GroupT>
+void check_points(std::vector<GroupT> const &points, size_t first, std::string const &message)
+{
+    const size_t num_chunks = (points.size() - first + CHECK_CHUNK_POINTS - 1) / CHECK_CHUNK_POINTS;
+    parallel::parallel_for(num_chunks, [&](size_t chunk) {
+        const size_t start = first + chunk * CHECK_CHUNK_POINTS;
+        const size_t end = std::min(points.size(), start + CHECK_CHUNK_POINTS);
+        for (size_t i = start; i < end; ++i)
+        {
+            if (!points[i].is_well_formed())
+            {
+                throw std::runtime_error(message);
+            }
+        }
+    });
+}
+
+} // namespace
+
+TranscriptLedger::TranscriptLedger(std::string const &path)
+    : path_(path)
+{
+    if (!is_file_exist(path) || get_file_size(path) < RECORD_SIZE)
+    {
+        return;
+    }
+
+    // A trailing partial record was torn by a crash mid-append, and is dropped.
+    auto buffer = read_file_into_buffer(path);
+    for (size_t offset = 0; offset + RECORD_SIZE <= buffer.size(); offset += RECORD_SIZE)
+    {
+        LedgerEntry entry;
+        if (deserialize_entry(&buffer[offset], entry))
+        {
+            entries_.emplace(std::string(entry.checksum.begin(), entry.checksum.end()), entry);
+        }
+    }
+}
+
+LedgerEntry const *TranscriptLedger::find(std::vector<char> const &checksum,
+                                          std::vector<char> const &transcript0_checksum,
+                                          std::vector<char> const &previous_checksum) const
+{
+    auto range = entries_.equal_range(std::string(checksum.begin(), checksum.end()));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.transcript0_checksum == transcript0_checksum && it->second.previous_checksum == previous_checksum)
+        {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+bool TranscriptLedger::is_verified(std::vector<char> const &checksum) const
+{
+    auto range = entries_.equal_range(std::string(checksum.begin(), checksum.end()));
+    return std::any_of(range.first, range.second, [](std::pair<const std::string, LedgerEntry> const &it) { return it.second.valid; });
+}
+
+void TranscriptLedger::append(LedgerEntry const &entry)
+{
+    auto record = serialize_entry(entry);
+
+    int fd = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1)
+    {
+        throw std::runtime_error("Failed to open ledger: " + path_);
+    }
+
+    // Drop any torn record first, so this one starts on a record boundary.
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && ftruncate(fd, st.st_size - st.st_size % RECORD_SIZE) == 0;
+    ok = ok && write(fd, &record[0], record.size()) == (ssize_t)record.size();
+    ok = ok && fdatasync(fd) == 0;
+    close(fd);
+    if (!ok)
+    {
+        throw std::runtime_error("Failed to append to ledger: " + path_);
+    }
+
+    entries_.emplace(std::string(entry.checksum.begin(), entry.checksum.end()), entry);
+}
+
+void read_trusted_transcript(std::vector<G1> &g1_x,
+                             std::vector<G2> &g2_x,
+                             Manifest &manifest,
+                             std::string const &path,
+                             TranscriptLedger const &ledger)
+{
+    read_transcript_manifest(manifest, path);
+    const size_t g1_start = g1_x.size();
+    const size_t g2_start = g2_x.size();
+    g1_x.reserve(g1_start + manifest.num_g1_points);
+    g2_x.reserve(g2_start + manifest.num_g2_points);
+
+    auto checksum = stream_transcript(
+        path,
+        manifest,
+        [&](char const *data, size_t size) {
+            const size_t start = g1_x.size();
+            g1_x.resize(start + size / G1_BYTES);
+            read_g1_elements_from_buffer(&g1_x[start], data, size / G1_BYTES, false);
+        },
+        [&](char const *data, size_t size) {
+            const size_t start = g2_x.size();
+            g2_x.resize(start + size / G2_BYTES);
+            read_g2_elements_from_buffer(&g2_x[start], data, size / G2_BYTES, false);
+        });
+
+    if (!ledger.is_verified(checksum))
+    {
+        check_points(g1_x, g1_start, "G1 points are not on the curve!");
+        check_points(g2_x, g2_start, "G2 points are not on the curve!");
+    }
+}
+
+} // namespace streaming
@@ -0,0 +1,58 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "streaming_transcript.hpp"
+#include <map>
+
+namespace streaming
+{
+
+// The outcome of verifying one transcript. Transcripts are identified by their Blake2b checksums.
+struct LedgerEntry
+{
+    std::vector<char> checksum;
+    Manifest manifest;
+    // The transcripts the verification was made against: transcript 0 of the same participant, and the previous
+    // transcript in the sequence, which is empty if there was none.
+    std::vector<char> transcript0_checksum;
+    std::vector<char> previous_checksum;
+    bool valid;
+};
+
+// A local, append-only record of completed transcript verifications, looked up by transcript checksum.
+// Every record carries a checksum of its own, and records that fail it, such as one torn by a crash, are ignored.
+class TranscriptLedger
+{
+  public:
+    // Loads the ledger at path, if it exists. New entries are appended to the same file.
+    explicit TranscriptLedger(std::string const &path);
+
+    // Finds the recorded outcome of verifying checksum against the given transcript 0 and previous transcript.
+    LedgerEntry const *find(std::vector<char> const &checksum,
+                            std::vector<char> const &transcript0_checksum,
+                            std::vector<char> const &previous_checksum) const;
+
+    // True if some recorded verification found the transcript with this checksum valid.
+    bool is_verified(std::vector<char> const &checksum) const;
+
+    // Records entry, and syncs it to disk before returning.
+    void append(LedgerEntry const &entry);
+
+    size_t size() const { return entries_.size(); }
+
+  private:
+    std::string path_;
+    std::multimap<std::string, LedgerEntry> entries_;
+};
+
+// Reads a transcript like read_transcript, but skips the per-point curve checks if ledger records it as verified.
+// Points are decoded unchecked while the checksum is computed, and are only checked afterwards if it isn't trusted.
+void read_trusted_transcript(std::vector<G1> &g1_x,
+                             std::vector<G2> &g2_x,
+                             Manifest &manifest,
+                             std::string const &path,
+                             TranscriptLedger const &ledger);
+
+} // namespace streaming
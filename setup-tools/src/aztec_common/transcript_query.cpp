@@ -0,0 +1,270 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "transcript_query.hpp"
+#include "streaming_g1.hpp"
+#include "streaming_g2.hpp"
+#include "thread_pool.hpp"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace streaming
+{
+
+namespace
+{
+
+constexpr size_t G1_BYTES = sizeof(Fq) * (USE_COMPRESSION ? 1 : 2);
+constexpr size_t G2_BYTES = sizeof(Fqe) * (USE_COMPRESSION ? 1 : 2);
+
+size_t parse_index(std::string const &str, std::string const &query)
+{
+    char *end;
+    size_t index = strtoul(str.c_str(), &end, 0);
+    if (str.empty() || *end != 0)
+    {
+        throw std::runtime_error("Invalid query: " + query);
+    }
+    return index;
+}
+
+void append_json(std::string &out, Fq const &value)
+{
+    auto bigint = value.as_bigint();
+    char hex[72];
+    snprintf(hex, sizeof(hex), "\"0x%016lx%016lx%016lx%016lx\"", bigint.data[3], bigint.data[2], bigint.data[1], bigint.data[0]);
+    out += hex;
+}
+
+// Appends value as 32 big-endian bytes.
+void append_binary(std::string &out, Fq const &value)
+{
+    auto bigint = value.as_bigint();
+    for (size_t i = 0; i < 4; ++i)
+    {
+        uint64_t limb = __builtin_bswap64(bigint.data[3 - i]);
+        out.append((char const *)&limb, sizeof(limb));
+    }
+}
+
+void append_point(std::string &out, G1 const &point, bool binary)
+{
+    if (binary)
+    {
+        append_binary(out, point.X);
+        append_binary(out, point.Y);
+        return;
+    }
+    out += "[";
+    append_json(out, point.X);
+    out += ",";
+    append_json(out, point.Y);
+    out += "]";
+}
+
+void append_point(std::string &out, G2 const &point, bool binary)
+{
+    if (binary)
+    {
+        append_binary(out, point.X.c0);
+        append_binary(out, point.X.c1);
+        append_binary(out, point.Y.c0);
+        append_binary(out, point.Y.c1);
+        return;
+    }
+    out += "[";
+    append_json(out, point.X.c0);
+    out += ",";
+    append_json(out, point.X.c1);
+    out += ",";
+    append_json(out, point.Y.c0);
+    out += ",";
+    append_json(out, point.Y.c1);
+    out += "]";
+}
+
+void read_points(G1 *points, char const *buffer, size_t num)
+{
+    read_g1_elements_from_buffer(points, buffer, num);
+}
+
+void read_points(G2 *points, char const *buffer, size_t num)
+{
+    read_g2_elements_from_buffer(points, buffer, num);
+}
+
+template <typename GroupT>
+std::string format_points(PointQuery const &piece, char const *buffer, bool binary)
+{
+    std::vector<GroupT> points(piece.count);
+    read_points(&points[0], buffer, piece.count);
+
+    std::string out;
+    for (size_t i = 0; i < piece.count; ++i)
+    {
+        if (!binary)
+        {
+            out += "{\"transcript\":" + std::to_string(piece.transcript) + ",\"group\":\"" + (piece.g2 ? "g2" : "g1") +
+                   "\",\"index\":" + std::to_string(piece.first + i) + ",\"point\":";
+        }
+        append_point(out, points[i], binary);
+        if (!binary)
+        {
+            out += "}\n";
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+MappedTranscript::MappedTranscript(std::string const &path)
+    : data_(nullptr)
+    , size_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::runtime_error("Transcript not found: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Manifest))
+    {
+        close(fd);
+        throw std::runtime_error("Transcript too small to hold a manifest: " + path);
+    }
+    size_ = st.st_size;
+    void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map transcript: " + path);
+    }
+    data_ = (char const *)data;
+
+    std::vector<char> buffer(data_, data_ + sizeof(Manifest));
+    read_manifest(buffer, manifest_);
+    if (size_ != get_transcript_size(manifest_))
+    {
+        munmap((void *)data_, size_);
+        throw std::runtime_error("Transcript size does not match manifest: " + path);
+    }
+}
+
+MappedTranscript::~MappedTranscript()
+{
+    munmap((void *)data_, size_);
+}
+
+char const *MappedTranscript::g1_points() const
+{
+    return data_ + sizeof(Manifest);
+}
+
+char const *MappedTranscript::g2_points() const
+{
+    return g1_points() + manifest_.num_g1_points * G1_BYTES;
+}
+
+PointQuery parse_point_query(std::string const &str, std::vector<std::unique_ptr<MappedTranscript>> const &transcripts)
+{
+    std::vector<std::string> parts;
+    for (size_t start = 0, end = 0; end != std::string::npos; start = end + 1)
+    {
+        end = str.find(':', start);
+        parts.push_back(str.substr(start, end == std::string::npos ? end : end - start));
+    }
+    if (parts.size() < 2 || parts.size() > 3 || (parts[parts.size() - 2] != "g1" && parts[parts.size() - 2] != "g2"))
+    {
+        throw std::runtime_error("Invalid query: " + str);
+    }
+
+    PointQuery query;
+    query.transcript = parts.size() == 3 ? parse_index(parts[0], str) : 0;
+    query.g2 = parts[parts.size() - 2] == "g2";
+    std::string const &range = parts.back();
+    size_t dash = range.find('-');
+    query.first = parse_index(range.substr(0, dash), str);
+    size_t last = dash == std::string::npos ? query.first : parse_index(range.substr(dash + 1), str);
+    if (last < query.first)
+    {
+        throw std::runtime_error("Invalid query: " + str);
+    }
+    query.count = last - query.first + 1;
+
+    if (query.transcript >= transcripts.size())
+    {
+        throw std::runtime_error("No transcript " + std::to_string(query.transcript) + " for query: " + str);
+    }
+    if (last >= transcripts[query.transcript]->num_points(query.g2))
+    {
+        throw std::runtime_error("Point not found for query: " + str);
+    }
+    return query;
+}
+
+std::vector<PointQuery> split_point_queries(std::vector<PointQuery> const &queries)
+{
+    std::vector<PointQuery> pieces;
+    for (auto const &query : queries)
+    {
+        for (size_t first = query.first; first < query.first + query.count; first += POINTS_PER_PIECE)
+        {
+            pieces.push_back({query.transcript, query.g2, first, std::min(POINTS_PER_PIECE, query.first + query.count - first)});
+        }
+    }
+    return pieces;
+}
+
+std::string format_point_piece(PointQuery const &piece, MappedTranscript const &transcript, bool binary)
+{
+    if (piece.g2)
+    {
+        return format_points<G2>(piece, transcript.g2_points() + piece.first * G2_BYTES, binary);
+    }
+    return format_points<G1>(piece, transcript.g1_points() + piece.first * G1_BYTES, binary);
+}
+
+void write_point_queries(std::vector<std::string> const &paths,
+                         std::vector<std::string> const &query_strings,
+                         bool binary,
+                         std::ostream &out,
+                         size_t pieces_per_round)
+{
+    std::vector<std::unique_ptr<MappedTranscript>> transcripts;
+    for (auto const &path : paths)
+    {
+        transcripts.emplace_back(new MappedTranscript(path));
+    }
+
+    std::vector<PointQuery> queries;
+    for (auto const &str : query_strings)
+    {
+        queries.push_back(parse_point_query(str, transcripts));
+    }
+    std::vector<PointQuery> pieces = split_point_queries(queries);
+
+    std::vector<std::string> outputs(pieces_per_round);
+    for (size_t start = 0; start < pieces.size(); start += pieces_per_round)
+    {
+        const size_t num = std::min(pieces_per_round, pieces.size() - start);
+        parallel::parallel_for(num, [&](size_t i) {
+            PointQuery const &piece = pieces[start + i];
+            outputs[i] = format_point_piece(piece, *transcripts[piece.transcript], binary);
+        });
+        for (size_t i = 0; i < num; ++i)
+        {
+            out.write(outputs[i].data(), outputs[i].size());
+        }
+    }
+    out.flush();
+}
+
+} // namespace streaming
@@ -0,0 +1,71 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "streaming_transcript.hpp"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace streaming
+{
+
+// Queries are split into pieces of at most this many points, and this many pieces are decoded in parallel before
+// their output is written, which bounds memory however many points are asked for.
+constexpr size_t POINTS_PER_PIECE = 1024;
+constexpr size_t PIECES_PER_ROUND = 256;
+
+// A transcript mapped into memory once, and shared by every query against it.
+class MappedTranscript
+{
+  public:
+    explicit MappedTranscript(std::string const &path);
+
+    ~MappedTranscript();
+
+    size_t num_points(bool g2) const { return g2 ? manifest_.num_g2_points : manifest_.num_g1_points; }
+
+    char const *g1_points() const;
+
+    char const *g2_points() const;
+
+  private:
+    MappedTranscript(const MappedTranscript &);
+    MappedTranscript &operator=(const MappedTranscript &);
+
+    char const *data_;
+    size_t size_;
+    Manifest manifest_;
+};
+
+// A query for count points of one group, starting at first, in one transcript.
+struct PointQuery
+{
+    size_t transcript;
+    bool g2;
+    size_t first;
+    size_t count;
+};
+
+// Parses [<transcript>:]<g1 || g2>:<point num>[-<last point num>], where the range is inclusive and the transcript
+// defaults to 0. Throws if the query is malformed, or asks for a transcript or point that isn't there.
+PointQuery parse_point_query(std::string const &str, std::vector<std::unique_ptr<MappedTranscript>> const &transcripts);
+
+// Splits queries into pieces of at most POINTS_PER_PIECE points, in order.
+std::vector<PointQuery> split_point_queries(std::vector<PointQuery> const &queries);
+
+// Decodes a piece, which validates that each point is on the curve, and formats it: a JSON object per line of the
+// transcript, group, index and point, or with binary, each coordinate as 32 big-endian bytes.
+std::string format_point_piece(PointQuery const &piece, MappedTranscript const &transcript, bool binary);
+
+// Maps the transcripts at paths, and writes the points of every query to out, in order. pieces_per_round pieces are
+// decoded at a time, on the shared thread pool. Every query is parsed before anything is written.
+void write_point_queries(std::vector<std::string> const &paths,
+                         std::vector<std::string> const &queries,
+                         bool binary,
+                         std::ostream &out,
+                         size_t pieces_per_round = PIECES_PER_ROUND);
+
+} // namespace streaming
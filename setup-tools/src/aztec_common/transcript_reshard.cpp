@@ -0,0 +1,158 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "transcript_reshard.hpp"
+#include "thread_pool.hpp"
+#include "transcript_writer.hpp"
+#include <sys/stat.h>
+#include <algorithm>
+
+namespace streaming
+{
+
+namespace
+{
+
+constexpr size_t G1_BYTES = sizeof(Fq) * (USE_COMPRESSION ? 1 : 2);
+constexpr size_t G2_BYTES = sizeof(Fqe) * (USE_COMPRESSION ? 1 : 2);
+
+// A run of raw point data within one input transcript.
+struct Segment
+{
+    size_t transcript;
+    size_t offset;
+    size_t size;
+};
+
+// Appends the byte ranges holding points [first, last) of a series split across transcripts. Transcript t holds
+// points [offsets[t], offsets[t + 1]) of point_size bytes each, starting at byte regions[t] of its file.
+void add_segments(std::vector<Segment> &segments,
+                  std::vector<size_t> const &offsets,
+                  std::vector<size_t> const &regions,
+                  size_t point_size,
+                  size_t first,
+                  size_t last)
+{
+    for (size_t t = 0; t + 1 < offsets.size() && first < last; ++t)
+    {
+        if (offsets[t + 1] <= first)
+        {
+            continue;
+        }
+        const size_t end = std::min(last, offsets[t + 1]);
+        segments.push_back({t, regions[t] + (first - offsets[t]) * point_size, (end - first) * point_size});
+        first = end;
+    }
+}
+
+void check_not_overwriting(TranscriptSet const &set, std::string const &path)
+{
+    struct stat out;
+    if (stat(path.c_str(), &out) != 0)
+    {
+        return;
+    }
+    for (size_t t = 0; t < set.size(); ++t)
+    {
+        struct stat in;
+        if (stat(set.paths[t].c_str(), &in) == 0 && in.st_dev == out.st_dev && in.st_ino == out.st_ino)
+        {
+            throw std::runtime_error("Output would overwrite input transcript: " + path);
+        }
+    }
+}
+
+} // namespace
+
+std::vector<Manifest> reshard_manifests(TranscriptSet const &set, size_t points_per_transcript, size_t max_points)
+{
+    Manifest const &first = set.manifests[0];
+    if (points_per_transcript == 0)
+    {
+        throw std::runtime_error("Points per transcript must be greater than 0.");
+    }
+    if (first.num_g2_points == 0)
+    {
+        throw std::runtime_error("Transcript 0 does not hold a g2^y point.");
+    }
+    if (set.num_g2_points() - 1 != first.total_g2_points)
+    {
+        throw std::runtime_error("Transcripts hold " + std::to_string(set.num_g2_points() - 1) + " G2 points, but manifests expect " + std::to_string(first.total_g2_points) + ".");
+    }
+
+    const size_t total_g1_points = std::min(max_points, (size_t)first.total_g1_points);
+    const size_t total_g2_points = std::min(max_points, (size_t)first.total_g2_points);
+    const size_t max_total = std::max(total_g1_points, total_g2_points);
+    const size_t num_transcripts = std::max((size_t)1, (max_total + points_per_transcript - 1) / points_per_transcript);
+
+    std::vector<Manifest> manifests(num_transcripts);
+    for (size_t i = 0; i < num_transcripts; ++i)
+    {
+        const size_t start_from = i * points_per_transcript;
+        Manifest &manifest = manifests[i];
+        manifest.transcript_number = i;
+        manifest.total_transcripts = num_transcripts;
+        manifest.total_g1_points = total_g1_points;
+        manifest.total_g2_points = total_g2_points;
+        manifest.num_g1_points = std::min(points_per_transcript, total_g1_points > start_from ? total_g1_points - start_from : 0);
+        manifest.num_g2_points = std::min(points_per_transcript, total_g2_points > start_from ? total_g2_points - start_from : 0);
+        manifest.start_from = start_from;
+    }
+    manifests[0].num_g2_points += 1;
+    return manifests;
+}
+
+std::vector<Manifest> reshard_transcripts(TranscriptSet const &set,
+                                          std::string const &out_dir,
+                                          size_t points_per_transcript,
+                                          size_t max_points)
+{
+    auto manifests = reshard_manifests(set, points_per_transcript, max_points);
+    for (size_t i = 0; i < manifests.size(); ++i)
+    {
+        check_not_overwriting(set, getTranscriptInPath(out_dir, i));
+    }
+
+    // The data is copied without being decoded, so corrupt input would otherwise pass straight into outputs with
+    // valid checksums.
+    read_transcript_checksums(set);
+
+    // G2 point offsets excluding g2^y, which sits at the end of transcript 0's G2 points.
+    std::vector<size_t> g2_offsets(set.g2_offsets);
+    std::vector<size_t> g1_regions(set.size(), sizeof(Manifest));
+    std::vector<size_t> g2_regions(set.size());
+    for (size_t t = 0; t < set.size(); ++t)
+    {
+        g2_offsets[t + 1] -= 1;
+        g2_regions[t] = sizeof(Manifest) + set.manifests[t].num_g1_points * G1_BYTES;
+    }
+    const size_t g2_y_offset = g2_regions[0] + (set.manifests[0].num_g2_points - 1) * G2_BYTES;
+
+    parallel::parallel_for(manifests.size(), [&](size_t i) {
+        Manifest const &manifest = manifests[i];
+        const size_t num_g2_points = manifest.num_g2_points - (i == 0 ? 1 : 0);
+
+        std::vector<Segment> segments;
+        add_segments(segments, set.g1_offsets, g1_regions, G1_BYTES, manifest.start_from, manifest.start_from + manifest.num_g1_points);
+        add_segments(segments, g2_offsets, g2_regions, G2_BYTES, manifest.start_from, manifest.start_from + num_g2_points);
+        if (i == 0)
+        {
+            segments.push_back({0, g2_y_offset, G2_BYTES});
+        }
+
+        TranscriptWriter writer(getTranscriptInPath(out_dir, i));
+        write_transcript_manifest(writer, manifest);
+        for (auto const &segment : segments)
+        {
+            stream_transcript_points(set.paths[segment.transcript], segment.offset, segment.size, [&](char const *data, size_t size) {
+                writer.write(data, size);
+            });
+        }
+        writer.finish();
+    });
+
+    return manifests;
+}
+
+} // namespace streaming
@@ -0,0 +1,25 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "transcript_set.hpp"
+#include <limits>
+
+namespace streaming
+{
+
+// Manifests for the first max_points G1 and G2 points of set, split points_per_transcript to a file. As with the
+// transcripts setup produces, transcript 0 carries one extra G2 point, g2^y, at the end of its G2 points.
+std::vector<Manifest> reshard_manifests(TranscriptSet const &set, size_t points_per_transcript, size_t max_points);
+
+// Rewrites set into out_dir as transcripts of points_per_transcript points, keeping only the first max_points.
+// Points are copied as raw bytes without being decoded, and each output transcript is assembled and hashed on its
+// own thread, with only a few blocks of each in memory at a time. Input checksums are validated before anything is
+// written. Returns the manifests written.
+std::vector<Manifest> reshard_transcripts(TranscriptSet const &set,
+                                          std::string const &out_dir,
+                                          size_t points_per_transcript,
+                                          size_t max_points = std::numeric_limits<size_t>::max());
+
+} // namespace streaming
@@ -0,0 +1,151 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "transcript_set.hpp"
+#include "streaming_g1.hpp"
+#include "thread_pool.hpp"
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+
+namespace streaming
+{
+
+namespace
+{
+
+constexpr size_t G1_BYTES = sizeof(Fq) * (USE_COMPRESSION ? 1 : 2);
+constexpr size_t G2_BYTES = sizeof(Fqe) * (USE_COMPRESSION ? 1 : 2);
+
+void validate_transcript_set(TranscriptSet const &set)
+{
+    Manifest const &first = set.manifests[0];
+    for (size_t i = 0; i < set.size(); ++i)
+    {
+        Manifest const &manifest = set.manifests[i];
+        std::string const &path = set.paths[i];
+        if (manifest.transcript_number != i)
+        {
+            throw std::runtime_error("Transcript number mismatch in " + path + ": expected " + std::to_string(i) + ", got " + std::to_string(manifest.transcript_number) + ".");
+        }
+        if (manifest.total_transcripts != set.size())
+        {
+            throw std::runtime_error("Found " + std::to_string(set.size()) + " transcripts, but " + path + " expects " + std::to_string(manifest.total_transcripts) + ".");
+        }
+        if (manifest.total_g1_points != first.total_g1_points || manifest.total_g2_points != first.total_g2_points)
+        {
+            throw std::runtime_error("Total points in " + path + " disagree with transcript 0.");
+        }
+        if (manifest.num_g1_points > 0 && manifest.start_from != set.g1_offsets[i])
+        {
+            throw std::runtime_error("G1 points in " + path + " do not continue on from the previous transcript.");
+        }
+    }
+    if (set.num_g1_points() != first.total_g1_points)
+    {
+        throw std::runtime_error("Transcripts hold " + std::to_string(set.num_g1_points()) + " G1 points, but manifests expect " + std::to_string(first.total_g1_points) + ".");
+    }
+}
+
+} // namespace
+
+TranscriptSet find_transcripts(std::string const &dir)
+{
+    TranscriptSet set;
+    set.g1_offsets.push_back(0);
+    set.g2_offsets.push_back(0);
+
+    for (size_t num = 0;; ++num)
+    {
+        std::string path = getTranscriptInPath(dir, num);
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+        {
+            break;
+        }
+
+        Manifest manifest;
+        if ((size_t)st.st_size < sizeof(Manifest))
+        {
+            throw std::runtime_error("Transcript too small to hold a manifest: " + path);
+        }
+        read_transcript_manifest(manifest, path);
+        if ((size_t)st.st_size != get_transcript_size(manifest))
+        {
+            throw std::runtime_error("Transcript size does not match manifest: " + path);
+        }
+
+        set.paths.push_back(path);
+        set.manifests.push_back(manifest);
+        set.g1_offsets.push_back(set.g1_offsets.back() + manifest.num_g1_points);
+        set.g2_offsets.push_back(set.g2_offsets.back() + manifest.num_g2_points);
+    }
+
+    if (set.size() == 0)
+    {
+        throw std::runtime_error("No input files found.");
+    }
+    validate_transcript_set(set);
+    return set;
+}
+
+std::vector<std::vector<char>> stream_transcripts(TranscriptSet const &set,
+                                                  size_t first,
+                                                  size_t count,
+                                                  PointSink const &on_g1,
+                                                  PointSink const &on_g2,
+                                                  size_t read_ahead)
+{
+    std::vector<std::vector<char>> checksums(count);
+    std::atomic<size_t> next(first);
+    const size_t end = first + count;
+
+    // Each lane loads one transcript at a time, so at most read_ahead are in flight. The async reads within a
+    // transcript keep the disk busy while its lane decodes.
+    parallel::parallel_for(std::min(std::max(read_ahead, (size_t)1), count), [&](size_t) {
+        for (size_t t = next++; t < end; t = next++)
+        {
+            Manifest manifest;
+            size_t g1_index = set.g1_offsets[t];
+            size_t g2_index = set.g2_offsets[t];
+            checksums[t - first] = stream_transcript(
+                set.paths[t],
+                manifest,
+                [&](char const *data, size_t size) {
+                    on_g1(t, g1_index, data, size);
+                    g1_index += size / G1_BYTES;
+                },
+                [&](char const *data, size_t size) {
+                    on_g2(t, g2_index, data, size);
+                    g2_index += size / G2_BYTES;
+                });
+        }
+    });
+
+    return checksums;
+}
+
+std::vector<std::vector<char>> read_transcript_checksums(TranscriptSet const &set, size_t read_ahead)
+{
+    auto skip = [](size_t, size_t, char const *, size_t) {};
+    return stream_transcripts(set, 0, set.size(), skip, skip, read_ahead);
+}
+
+void load_transcripts_g1_points(TranscriptSet const &set, std::vector<G1> &g1_x, size_t read_ahead)
+{
+    const size_t base = g1_x.size();
+    g1_x.resize(base + set.num_g1_points());
+
+    stream_transcripts(
+        set,
+        0,
+        set.size(),
+        [&](size_t, size_t point_index, char const *data, size_t size) {
+            read_g1_elements_from_buffer(&g1_x[base + point_index], data, size / G1_BYTES);
+        },
+        [](size_t, size_t, char const *, size_t) {},
+        read_ahead);
+}
+
+} // namespace streaming
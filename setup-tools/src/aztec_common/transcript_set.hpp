@@ -0,0 +1,53 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include "streaming_transcript.hpp"
+
+namespace streaming
+{
+
+// Number of transcripts loaded at the same time by default. Each load decodes on its own thread.
+constexpr size_t DEFAULT_READ_AHEAD = 8;
+
+// Every transcript in a directory, with manifests validated as a set.
+struct TranscriptSet
+{
+    std::vector<std::string> paths;
+    std::vector<Manifest> manifests;
+    // Index of each transcript's first point within the concatenated series, with a final entry for the total.
+    std::vector<size_t> g1_offsets;
+    std::vector<size_t> g2_offsets;
+
+    size_t size() const { return paths.size(); }
+    size_t num_g1_points() const { return g1_offsets.back(); }
+    size_t num_g2_points() const { return g2_offsets.back(); }
+};
+
+// Receives consecutive chunks of one transcript's points. point_index is the index of the chunk's first point in
+// the concatenated series. Sinks are called concurrently, but never for the same transcript at once.
+using PointSink = std::function<void(size_t transcript, size_t point_index, char const *data, size_t size)>;
+
+// Finds transcript0.dat, transcript1.dat, ... in dir and reads their manifests. Throws if none exist, or if they
+// don't describe one complete sequence: numbered in order, agreeing on the totals, with contiguous G1 points and
+// file sizes that match.
+TranscriptSet find_transcripts(std::string const &dir);
+
+// Streams count transcripts starting from first, up to read_ahead at a time, validating each checksum.
+// Returns the checksums in transcript order.
+std::vector<std::vector<char>> stream_transcripts(TranscriptSet const &set,
+                                                  size_t first,
+                                                  size_t count,
+                                                  PointSink const &on_g1,
+                                                  PointSink const &on_g2,
+                                                  size_t read_ahead = DEFAULT_READ_AHEAD);
+
+// Validates every transcript's checksum, and returns them in order.
+std::vector<std::vector<char>> read_transcript_checksums(TranscriptSet const &set, size_t read_ahead = DEFAULT_READ_AHEAD);
+
+// Appends the G1 points of every transcript in the set to g1_x. The destination is sized once up front and each
+// transcript decodes straight into its own slice of it.
+void load_transcripts_g1_points(TranscriptSet const &set, std::vector<G1> &g1_x, size_t read_ahead = DEFAULT_READ_AHEAD);
+
+} // namespace streaming
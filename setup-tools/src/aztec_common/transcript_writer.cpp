@@ -0,0 +1,253 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include "transcript_writer.hpp"
+#include "checksum.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace streaming
+{
+
+namespace
+{
+
+size_t round_up(size_t size, size_t alignment)
+{
+    return ((size + alignment - 1) / alignment) * alignment;
+}
+
+} // namespace
+
+TranscriptWriter::TranscriptWriter(std::string const &path, bool direct_io, bool sync, size_t block_size, size_t num_blocks)
+    : path_(path)
+    , fd_(-1)
+    , direct_io_(direct_io)
+    , sync_(sync)
+    , finished_(false)
+    , block_size_(direct_io ? round_up(block_size, DIRECT_IO_ALIGNMENT) : block_size)
+    , head_(0)
+    , tail_(0)
+    , pending_(0)
+    , offset_(0)
+    , done_(false)
+{
+    if (block_size_ == 0 || num_blocks < 2)
+    {
+        throw std::runtime_error("Transcript writer needs at least two non-empty blocks.");
+    }
+
+    // Every block has room for the checksum, so the tail and checksum can go out in a single write.
+    const size_t allocation_size = round_up(block_size_ + checksum::BLAKE2B_CHECKSUM_LENGTH, DIRECT_IO_ALIGNMENT);
+    blocks_.resize(num_blocks, nullptr);
+    block_sizes_.resize(num_blocks);
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        blocks_[i] = static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, allocation_size));
+        if (blocks_[i] == nullptr)
+        {
+            release_blocks();
+            throw std::bad_alloc();
+        }
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (direct_io_)
+    {
+        fd_ = open(path_.c_str(), flags | O_DIRECT, 0644);
+        if (fd_ == -1 && errno == EINVAL)
+        {
+            // Filesystem doesn't support O_DIRECT (e.g. tmpfs). Fall back to buffered writes.
+            direct_io_ = false;
+        }
+    }
+    if (fd_ == -1)
+    {
+        fd_ = open(path_.c_str(), flags, 0644);
+    }
+    if (fd_ == -1)
+    {
+        release_blocks();
+        throw std::runtime_error("Failed to open " + path_ + " for writing.");
+    }
+
+    blake2b_init(&checksum_state_, checksum::BLAKE2B_CHECKSUM_LENGTH);
+    thread_ = std::thread(&TranscriptWriter::write_loop, this);
+}
+
+TranscriptWriter::~TranscriptWriter()
+{
+    stop();
+    if (fd_ != -1)
+    {
+        close(fd_);
+    }
+    if (!finished_)
+    {
+        unlink(path_.c_str());
+    }
+    release_blocks();
+}
+
+void TranscriptWriter::write(char const *data, size_t size)
+{
+    while (size > 0)
+    {
+        size_t to_copy = std::min(size, block_size_ - offset_);
+        memcpy(blocks_[head_] + offset_, data, to_copy);
+        offset_ += to_copy;
+        data += to_copy;
+        size -= to_copy;
+        if (offset_ == block_size_)
+        {
+            submit_block();
+        }
+    }
+}
+
+void TranscriptWriter::finish()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+    stop();
+    check_error();
+
+    // The write thread has exited, so the checksum state is ours to finalize.
+    char *block = blocks_[head_];
+    blake2b_update(&checksum_state_, block, offset_);
+    blake2b_final(&checksum_state_, block + offset_, checksum::BLAKE2B_CHECKSUM_LENGTH);
+
+    if (direct_io_)
+    {
+        // The tail is not a multiple of the block alignment, so it can't be written with O_DIRECT.
+        int flags = fcntl(fd_, F_GETFL);
+        fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+    }
+    write_fully(block, offset_ + checksum::BLAKE2B_CHECKSUM_LENGTH);
+
+    if (sync_ && fdatasync(fd_) != 0)
+    {
+        throw std::runtime_error("Failed to sync " + path_ + ".");
+    }
+    int result = close(fd_);
+    fd_ = -1;
+    if (result != 0)
+    {
+        throw std::runtime_error("Failed to close " + path_ + ".");
+    }
+    finished_ = true;
+}
+
+// Hands the current block to the write thread, and waits until the next block in the ring is free.
+void TranscriptWriter::submit_block()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        block_sizes_[head_] = offset_;
+        head_ = (head_ + 1) % blocks_.size();
+        ++pending_;
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return pending_ < blocks_.size(); });
+    }
+    offset_ = 0;
+    check_error();
+}
+
+void TranscriptWriter::write_loop()
+{
+    while (true)
+    {
+        size_t index;
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return pending_ > 0 || done_; });
+            if (pending_ == 0)
+            {
+                return;
+            }
+            index = tail_;
+            failed = !error_.empty();
+        }
+
+        if (!failed)
+        {
+            blake2b_update(&checksum_state_, blocks_[index], block_sizes_[index]);
+            try
+            {
+                write_fully(blocks_[index], block_sizes_[index]);
+            }
+            catch (std::exception const &err)
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                error_ = err.what();
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            tail_ = (tail_ + 1) % blocks_.size();
+            --pending_;
+        }
+        cv_.notify_all();
+    }
+}
+
+void TranscriptWriter::write_fully(char const *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            throw std::runtime_error("Failed to write transcript to " + path_ + ". Out of storage space?");
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void TranscriptWriter::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void TranscriptWriter::release_blocks()
+{
+    for (size_t i = 0; i < blocks_.size(); ++i)
+    {
+        free(blocks_[i]);
+    }
+    blocks_.clear();
+}
+
+void TranscriptWriter::check_error()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!error_.empty())
+    {
+        throw std::runtime_error(error_);
+    }
+}
+
+} // namespace streaming
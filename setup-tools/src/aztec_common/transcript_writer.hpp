@@ -0,0 +1,77 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+#include <stddef.h>
+#include <blake2.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace streaming
+{
+
+// Streams a transcript to disk through a small ring of aligned blocks.
+// The caller serializes into the current block while filled blocks are hashed and written on a background thread.
+// finish() appends the Blake2b checksum of everything written, so the output is identical to hashing a whole-file
+// buffer, but memory overhead is fixed at num_blocks * block_size.
+class TranscriptWriter
+{
+  public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 4 * 1024 * 1024;
+    static constexpr size_t DEFAULT_NUM_BLOCKS = 4;
+    static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+    // direct_io opens the file with O_DIRECT (if the filesystem supports it), bypassing the page cache.
+    // sync calls fdatasync before the file is closed.
+    TranscriptWriter(std::string const &path,
+                     bool direct_io = false,
+                     bool sync = false,
+                     size_t block_size = DEFAULT_BLOCK_SIZE,
+                     size_t num_blocks = DEFAULT_NUM_BLOCKS);
+
+    // Abandoning a writer without calling finish() removes the incomplete file.
+    ~TranscriptWriter();
+
+    void write(char const *data, size_t size);
+
+    // Writes the last partial block followed by the checksum, and closes the file.
+    void finish();
+
+  private:
+    TranscriptWriter(const TranscriptWriter &);
+    TranscriptWriter &operator=(const TranscriptWriter &);
+
+    void submit_block();
+    void write_loop();
+    void write_fully(char const *data, size_t size);
+    void stop();
+    void release_blocks();
+    void check_error();
+
+    std::string path_;
+    int fd_;
+    bool direct_io_;
+    bool sync_;
+    bool finished_;
+    size_t block_size_;
+
+    std::vector<char *> blocks_;
+    std::vector<size_t> block_sizes_;
+    size_t head_;
+    size_t tail_;
+    size_t pending_;
+    size_t offset_;
+    bool done_;
+    std::string error_;
+
+    blake2b_state checksum_state_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+} // namespace streaming
@@ -8,9 +8,19 @@
 
 int main(int argc, char **argv)
 {
+    // A fixed-base table of g1x, to multi-exponentiate against instead of g1x itself.
+    std::string table_path;
+    if (argc > 2 && std::string(argv[1]) == "--fixed-base")
+    {
+        table_path = argv[2];
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
     if (argc < 4)
     {
-        std::cout << "usage: " << argv[0] << " <generator path> <g1x path> <kmax> [batches]" << std::endl;
+        std::cout << "usage: " << argv[0] << " [--fixed-base <table path>] <generator path> <g1x path> <kmax> [batches]" << std::endl;
         return 1;
     }
     const std::string generator_path = argv[1];
@@ -22,7 +32,7 @@ int main(int argc, char **argv)
 
     try
     {
-        generate_h::compute_h(generator_path, g1x_path, kmax + 1, batches);
+        generate_h::compute_h(generator_path, g1x_path, kmax + 1, batches, table_path);
     }
     catch (std::exception const &e)
     {
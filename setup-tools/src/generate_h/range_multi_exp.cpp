@@ -4,11 +4,10 @@
  **/
 #include "range_multi_exp.hpp"
 
+#include <aztec_common/pippenger_bberg.hpp>
 #include <aztec_common/streaming.hpp>
 #include <aztec_common/timer.hpp>
 
-#include <barretenberg/groups/scalar_multiplication.hpp>
-
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -23,7 +22,7 @@ void *map_file(std::string const &filename)
     assert(fd != -1);
 
     struct stat sb;
-    if (fstat(fd, &sb) != -1)
+    if (fstat(fd, &sb) == -1)
     {
         assert(false);
     }
@@ -35,31 +34,34 @@ void *map_file(std::string const &filename)
     return data;
 }
 
-bb::g1::element process_range(bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num)
+bb::g1::element process_range(bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num, fixed_base::Table const *table)
 {
-    // Scalars are mutated, so copy them first.
-    auto range_coefficients = std::vector<bb::fr::field_t>(num);
-    memcpy(&range_coefficients[0], generator_coefficients + 1 + start, num * sizeof(bb::fr::field_t));
-    return bb::scalar_multiplication::pippenger_low_memory(&range_coefficients[0], powers_of_x + 1 + start, num);
+    if (table)
+    {
+        return fixed_base::multi_exp(*table, 1 + start, generator_coefficients + 1 + start, num);
+    }
+
+    // Scalars are mutated, so each thread copies its share first.
+    return pippenger::multi_exp_bberg(powers_of_x + 1 + start, generator_coefficients + 1 + start, num, true);
 }
 
-bb::g1::element batch_process_range(size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial)
+bb::g1::element batch_process_range(size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial, fixed_base::Table const *table)
 {
     size_t batch_size = polynomial_degree / batch_num;
-    size_t leftovers = polynomial_degree % batch_size;
+    size_t leftovers = polynomial_degree % batch_num;
 
     bb::g1::element result = {.x = {0}, .y = {0}, .z = {0}};
     bb::g1::set_infinity(result);
     for (size_t i = 0; i < batch_num; ++i)
     {
-        auto r = process_range(g1_x, generator_polynomial, batch_size * i, (i == batch_num - 1) ? batch_size + leftovers : batch_size);
+        auto r = process_range(g1_x, generator_polynomial, batch_size * i, (i == batch_num - 1) ? batch_size + leftovers : batch_size, table);
         bb::g1::add(r, result, result);
     }
 
     return result;
 }
 
-void compute_h(std::string const &generator_path, std::string const &g1x_path, size_t polynomial_degree, size_t batches)
+void compute_h(std::string const &generator_path, std::string const &g1x_path, size_t polynomial_degree, size_t batches, std::string const &table_path)
 {
     Timer total_timer;
 
@@ -67,10 +69,18 @@ void compute_h(std::string const &generator_path, std::string const &g1x_path, s
     Timer data_timer;
     bb::fr::field_t *generator_coefficients = (bb::fr::field_t *)map_file(generator_path);
     bb::g1::affine_element *g1_x = (bb::g1::affine_element *)map_file(g1x_path);
+
+    // The points used are g1_x[1], ..., g1_x[polynomial_degree].
+    fixed_base::Table table = { 0, 0, nullptr };
+    if (!table_path.empty())
+    {
+        table = fixed_base::map_table(table_path);
+        fixed_base::check_table(table, g1_x, polynomial_degree + 1);
+    }
     std::cerr << "Loaded in " << data_timer.toString() << "s" << std::endl;
 
     Timer compute_timer;
-    bb::g1::element result = batch_process_range(polynomial_degree, batches, g1_x, generator_coefficients);
+    bb::g1::element result = batch_process_range(polynomial_degree, batches, g1_x, generator_coefficients, table_path.empty() ? nullptr : &table);
 
     std::cerr << "Compute time: " << compute_timer.toString() << "s" << std::endl;
     std::cerr << "Total time: " << total_timer.toString() << "s" << std::endl;
@@ -7,16 +7,19 @@
 #include <string>
 #include <barretenberg/fields/fr.hpp>
 #include <barretenberg/groups/g1.hpp>
+#include <aztec_common/fixed_base_bberg.hpp>
 
 namespace bb = barretenberg;
 
 namespace generate_h
 {
 
-bb::g1::element process_range(bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num);
+// Given a table of powers_of_x (see fixed_base_bberg.hpp), the multi-exponentiation runs against it instead.
+bb::g1::element process_range(bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num, fixed_base::Table const *table = nullptr);
 
-bb::g1::element batch_process_range(size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial);
+bb::g1::element batch_process_range(size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial, fixed_base::Table const *table = nullptr);
 
-void compute_h(std::string const &generator_path, std::string const& g1x_path, size_t polynomial_degree, size_t batches);
+// With table_path, the fixed-base table of g1x written by prep_range_data --fixed-base is mapped and used.
+void compute_h(std::string const &generator_path, std::string const& g1x_path, size_t polynomial_degree, size_t batches, std::string const &table_path = std::string());
 
 } // namespace generate_h
\ No newline at end of file
@@ -5,12 +5,79 @@
 #include <iostream>
 #include <string>
 #include <aztec_common/streaming_transcript.hpp>
+#include <aztec_common/transcript_query.hpp>
+
+namespace
+{
+
+void print_usage(char const *name)
+{
+    std::cout << "usage: " << name << " <transcript path> <g1 || g2> <point num>" << std::endl;
+    std::cout << "       " << name << " --batch [--binary] <transcript path>... [-- <query>...]" << std::endl;
+    std::cout << "query: [<transcript>:]<g1 || g2>:<point num>[-<last point num>], read from stdin if none are given" << std::endl;
+}
+
+int run_batch_command(int argc, char **argv)
+{
+    bool binary = false;
+    int arg = 2;
+    if (arg < argc && std::string(argv[arg]) == "--binary")
+    {
+        binary = true;
+        ++arg;
+    }
+
+    std::vector<std::string> paths;
+    for (; arg < argc && std::string(argv[arg]) != "--"; ++arg)
+    {
+        paths.push_back(argv[arg]);
+    }
+    if (paths.empty())
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> queries;
+    if (arg < argc)
+    {
+        queries.assign(argv + arg + 1, argv + argc);
+    }
+    else
+    {
+        std::string query;
+        while (std::cin >> query)
+        {
+            queries.push_back(query);
+        }
+    }
+
+    libff::alt_bn128_pp::init_public_params();
+
+    try
+    {
+        streaming::write_point_queries(paths, queries, binary, std::cout);
+        return 0;
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
+} // namespace
 
 int main(int argc, char **argv)
 {
+    if (argc >= 2 && std::string(argv[1]) == "--batch")
+    {
+        return run_batch_command(argc, argv);
+    }
+
     if (argc != 4)
     {
-        std::cout << "usage: " << argv[0] << " <transcript path> <g1 || g2> <point num>" << std::endl;
+        print_usage(argv[0]);
         return 1;
     }
     std::string const transcript_path(argv[1]);
@@ -66,4 +133,4 @@ int main(int argc, char **argv)
         std::cerr << err.what() << std::endl;
         return 1;
     }
-}
\ No newline at end of file
+}
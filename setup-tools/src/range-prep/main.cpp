@@ -1,45 +1,34 @@
 #include <barretenberg/fields/fr.hpp>
 #include <barretenberg/groups/g1.hpp>
-#include <aztec_common/streaming_transcript.hpp>
+#include <aztec_common/fixed_base_bberg.hpp>
+#include <aztec_common/streaming_bberg.hpp>
+#include <algorithm>
 #include <fstream>
 
 namespace bb = barretenberg;
 
+constexpr size_t READ_AHEAD = 2;
+
 void transform_g1x(std::string const &setup_db_path, std::string const& output)
 {
   std::ofstream file(output);
-  G1 one = G1::one();
-  one.to_affine_coordinates();
+  bb::g1::affine_element one = bb::g1::affine_one();
   file.write((char *)&one, sizeof(bb::g1::affine_element));
 
-  size_t num = 0;
-  std::string filename = streaming::getTranscriptInPath(setup_db_path, num);
+  auto set = streaming::find_transcripts(setup_db_path);
 
-  while (streaming::is_file_exist(filename))
+  // Load a couple of transcripts at a time, which bounds memory to two transcripts' worth of points.
+  std::vector<bb::g1::affine_element> g1_x;
+  for (size_t first = 0; first < set.size(); first += READ_AHEAD)
   {
-    std::cout << "Loading " << filename << "..." << std::endl;
-    streaming::Manifest manifest;
-    streaming::read_transcript_manifest(manifest, filename);
-    std::vector<G1> g1_x;
-    streaming::read_transcript_g1_points(g1_x, filename, 0, manifest.num_g1_points);
-
-    // Transform to affine.
-    std::vector<bb::g1::affine_element> bx(g1_x.size());
-    for (size_t i = 0; i < g1_x.size(); ++i)
-    {
-      g1_x[i].to_affine_coordinates();
-      memcpy(&bx[i], &g1_x[i], sizeof(bb::g1::affine_element));
-    }
+    const size_t count = std::min(READ_AHEAD, set.size() - first);
+    const size_t num_points = set.g1_offsets[first + count] - set.g1_offsets[first];
+    std::cout << "Loading transcripts " << first << " to " << first + count - 1 << "..." << std::endl;
+    g1_x.resize(num_points);
+    streaming::load_transcripts_bberg_g1_points(set, first, count, &g1_x[0], READ_AHEAD);
 
-    std::cout << "Writing " << g1_x.size() << " points..." << std::endl;
-    file.write((char *)&bx[0], bx.size() * sizeof(bb::g1::affine_element));
-
-    filename = streaming::getTranscriptInPath(setup_db_path, ++num);
-  }
-
-  if (num == 0)
-  {
-    throw std::runtime_error("No input files found.");
+    std::cout << "Writing " << num_points << " points..." << std::endl;
+    file.write((char *)&g1_x[0], num_points * sizeof(bb::g1::affine_element));
   }
 
   std::cout << "Done." << std::endl;
@@ -47,19 +36,27 @@ void transform_g1x(std::string const &setup_db_path, std::string const& output)
 
 int main(int argc, char **argv)
 {
-  if (argc != 3)
+  // Writes the fixed-base table of the points in a file written by the mode below, for range and generate_h.
+  const bool write_table = argc > 1 && std::string(argv[1]) == "--fixed-base";
+  if (write_table ? (argc != 5 && argc != 6) : argc != 3)
   {
     std::cout << "usage: " << argv[0] << " <setup db path> <output>" << std::endl;
+    std::cout << "       " << argv[0] << " --fixed-base <g1x path> <output> <num points> [window bits]" << std::endl;
     return 1;
   }
-  const std::string setup_db_path = argv[1];
-  const std::string output = argv[2];
-
-  libff::alt_bn128_pp::init_public_params();
 
   try
   {
-    transform_g1x(setup_db_path, output);
+    if (write_table)
+    {
+      const size_t num_points = strtoul(argv[4], NULL, 0);
+      const size_t window_bits = argc > 5 ? strtoul(argv[5], NULL, 0) : fixed_base::DEFAULT_WINDOW_BITS;
+      fixed_base::write_table(argv[2], num_points, window_bits, argv[3]);
+    }
+    else
+    {
+      transform_g1x(argv[1], argv[2]);
+    }
   }
   catch (std::exception const &err)
   {
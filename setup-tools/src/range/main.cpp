@@ -7,17 +7,76 @@
 
 int main(int argc, char **argv)
 {
-    if (argc < 5)
+    const bool all = argc > 1 && std::string(argv[1]) == "--all";
+
+    // A fixed-base table of g1x, to multi-exponentiate against instead of g1x itself.
+    std::string table_path;
+    if (!all && argc > 2 && std::string(argv[1]) == "--fixed-base")
+    {
+        table_path = argv[2];
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (all ? argc != 6 : argc < 5)
     {
-        std::cout << "usage: " << argv[0] << " <generator path> <g1x path> <index to compute> <kmax> <batches>" << std::endl;
+        std::cout << "usage: " << argv[0] << " [--fixed-base <table path>] <generator path> <g1x path> <index to compute> <kmax> <batches>" << std::endl;
+        std::cout << "       " << argv[0] << " [--fixed-base <table path>] <generator path> <g1x path> <first index>-<last index> <kmax> <batches>" << std::endl;
+        std::cout << "       " << argv[0] << " [--fixed-base <table path>] <generator path> <g1x path> - <kmax> <batches>" << std::endl;
+        std::cout << "       " << argv[0] << " --all <generator path> <g1x path> <kmax> <output path>" << std::endl;
         return 1;
     }
+
+    // Every index from 0 to kmax, in one pass.
+    if (all)
+    {
+        try
+        {
+            compute_all_range_polynomials(argv[2], argv[3], strtol(argv[4], NULL, 0) + 1, argv[5]);
+        }
+        catch (std::exception const &err)
+        {
+            std::cerr << err.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     const std::string generator_path = argv[1];
     const std::string g1x_path = argv[2];
-    const size_t range_index = (size_t)atoi(argv[3]);
+    const std::string indices = argv[3];
     const size_t kmax = strtol(argv[4], NULL, 0);
     const size_t batches = argc > 5 ? strtol(argv[5], NULL, 0) : 4;
 
-    compute_range_polynomials(generator_path, g1x_path, range_index, kmax + 1, batches);
+    try
+    {
+        // Indices separated by whitespace on stdin, each answered as it is read.
+        if (indices == "-")
+        {
+            compute_range_polynomials(
+                generator_path, g1x_path, [](size_t &range_index) { return (bool)(std::cin >> range_index); }, kmax + 1, batches, table_path);
+            return 0;
+        }
+
+        // An inclusive range of indices.
+        const size_t dash = indices.find('-');
+        if (dash != std::string::npos)
+        {
+            size_t next = strtoul(indices.substr(0, dash).c_str(), NULL, 0);
+            const size_t last = strtoul(indices.substr(dash + 1).c_str(), NULL, 0);
+            compute_range_polynomials(
+                generator_path, g1x_path, [&](size_t &range_index) { range_index = next++; return range_index <= last; }, kmax + 1, batches, table_path);
+            return 0;
+        }
+
+        const size_t range_index = (size_t)atoi(indices.c_str());
+        compute_range_polynomials(generator_path, g1x_path, range_index, kmax + 1, batches, table_path);
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
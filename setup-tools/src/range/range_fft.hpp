@@ -0,0 +1,65 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+// Computes every range point in one pass, rather than one multi-exponentiation per point.
+//
+// The point for k is the commitment to G(X) / (X - k), for the generator polynomial G(X) = (X - 0)(X - 1)...(X - kmax)
+// with coefficients c. The quotient's coefficient of X^i is sum_m c_(i + m + 1).k^m, so against the powers of x g the
+// point is sum_m k^m.H_m, with H_m = sum_i c_(i + m + 1).g_i. H is a single Toeplitz product of the coefficients with
+// the powers of x, and the points are the evaluations at 0, ..., kmax of the polynomial with coefficients H. Both run
+// on FFTs over polynomials with group element coefficients: the product in O(kmax log kmax) scalar multiplications,
+// and the evaluations, down a tree of remainders, in O(kmax log^2 kmax). Computing each point on its own is O(kmax^2).
+//
+// Polynomials are vectors of coefficients, lowest degree first. Their coefficients are either field elements or
+// group elements, multiplied by field elements. FieldT must have power of two roots of unity up to the sizes used.
+namespace range_fft
+{
+
+// Nodes of the evaluation tree with at most this many points evaluate their remainder directly. The points are small
+// integers, so the scalar multiplications doing so are short, and below this size cheaper than splitting further.
+constexpr size_t LEAF_POINTS = 128;
+
+// FFT butterflies, or pointwise products, per task.
+constexpr size_t VALUES_PER_TASK = 1024;
+
+// Transforms values in place, for omega of order values.size(), a power of two.
+template <typename FieldT, typename ValueT>
+void fft(std::vector<ValueT> &values, FieldT const &omega);
+
+// a * b mod (X^size - 1), for size a power of two.
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> cyclic_multiply(std::vector<FieldT> const &a, std::vector<ValueT> const &b, size_t size);
+
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> multiply(std::vector<FieldT> const &a, std::vector<ValueT> const &b);
+
+// 1 / f mod X^size, for f(0) != 0.
+template <typename FieldT>
+std::vector<FieldT> inverse_series(std::vector<FieldT> const &f, size_t size);
+
+// p mod m, for monic m.
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> remainder(std::vector<ValueT> const &p, std::vector<FieldT> const &m);
+
+// (X - first)(X - (first + 1))...(X - (last - 1)).
+template <typename FieldT>
+std::vector<FieldT> subproduct(size_t first, size_t last);
+
+// p(0), p(1), ..., p(num_points - 1).
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> evaluate(std::vector<ValueT> const &p, size_t num_points);
+
+// The range points for k = 0, ..., kmax, given the kmax + 2 coefficients of the generator polynomial and the first
+// kmax + 1 powers of x.
+template <typename FieldT, typename GroupT>
+std::vector<GroupT> compute_range_points(std::vector<FieldT> const &generator_polynomial, GroupT const *powers_of_x);
+
+} // namespace range_fft
+
+#include "range_fft.tcc"
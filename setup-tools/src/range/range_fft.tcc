@@ -0,0 +1,273 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include <algorithm>
+
+#include <aztec_common/thread_pool.hpp>
+#include <libff/algebra/fields/field_utils.hpp>
+
+#include "range_fft.hpp"
+
+namespace range_fft
+{
+
+inline size_t log2_ceil(size_t n)
+{
+    size_t bits = 0;
+    while (((size_t)1 << bits) < n)
+    {
+        ++bits;
+    }
+    return bits;
+}
+
+template <typename FieldT, typename ValueT>
+void fft(std::vector<ValueT> &values, FieldT const &omega)
+{
+    const size_t size = values.size();
+    for (size_t i = 1, j = 0; i < size; ++i)
+    {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            std::swap(values[i], values[j]);
+        }
+    }
+
+    // omega^0, ..., omega^(size / 2 - 1). The stage combining halves of length half takes every size / (2 half)th.
+    std::vector<FieldT> twiddles(size / 2, FieldT::one());
+    for (size_t i = 1; i < twiddles.size(); ++i)
+    {
+        twiddles[i] = twiddles[i - 1] * omega;
+    }
+
+    const size_t num_butterflies = size / 2;
+    const size_t num_tasks = (num_butterflies + VALUES_PER_TASK - 1) / VALUES_PER_TASK;
+    for (size_t half = 1; half < size; half *= 2)
+    {
+        const size_t stride = size / (2 * half);
+        parallel::parallel_for(num_tasks, [&](size_t task) {
+            const size_t end = std::min(num_butterflies, (task + 1) * VALUES_PER_TASK);
+            for (size_t butterfly = task * VALUES_PER_TASK; butterfly < end; ++butterfly)
+            {
+                const size_t j = butterfly % half;
+                const size_t i = (butterfly / half) * 2 * half + j;
+                ValueT t = twiddles[j * stride] * values[i + half];
+                values[i + half] = values[i] - t;
+                values[i] = values[i] + t;
+            }
+        });
+    }
+}
+
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> cyclic_multiply(std::vector<FieldT> const &a, std::vector<ValueT> const &b, size_t size)
+{
+    // X^size = 1, so coefficients past size wrap around.
+    std::vector<FieldT> a_folded(std::min(a.size(), size), FieldT::zero());
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        a_folded[i % size] = a_folded[i % size] + a[i];
+    }
+    std::vector<ValueT> b_folded(std::min(b.size(), size), ValueT::zero());
+    for (size_t i = 0; i < b.size(); ++i)
+    {
+        b_folded[i % size] = b_folded[i % size] + b[i];
+    }
+
+    // The transforms cost about size.(log2(size) + 1) multiplications of b's coefficients, the schoolbook product one
+    // per pair of coefficients.
+    if (a_folded.size() * b_folded.size() <= size * (log2_ceil(size) + 1))
+    {
+        std::vector<ValueT> result(size, ValueT::zero());
+        for (size_t i = 0; i < a_folded.size(); ++i)
+        {
+            for (size_t j = 0; j < b_folded.size(); ++j)
+            {
+                result[(i + j) % size] = result[(i + j) % size] + a_folded[i] * b_folded[j];
+            }
+        }
+        return result;
+    }
+
+    a_folded.resize(size, FieldT::zero());
+    b_folded.resize(size, ValueT::zero());
+    const FieldT omega = libff::get_root_of_unity<FieldT>(size);
+    fft(a_folded, omega);
+    fft(b_folded, omega);
+
+    // The inverse transform's 1 / size goes on a's side, where it costs a field multiplication.
+    const FieldT size_inverse = FieldT((long)size).inverse();
+    parallel::parallel_for((size + VALUES_PER_TASK - 1) / VALUES_PER_TASK, [&](size_t task) {
+        const size_t end = std::min(size, (task + 1) * VALUES_PER_TASK);
+        for (size_t i = task * VALUES_PER_TASK; i < end; ++i)
+        {
+            b_folded[i] = (a_folded[i] * size_inverse) * b_folded[i];
+        }
+    });
+    fft(b_folded, omega.inverse());
+    return b_folded;
+}
+
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> multiply(std::vector<FieldT> const &a, std::vector<ValueT> const &b)
+{
+    if (a.empty() || b.empty())
+    {
+        return std::vector<ValueT>();
+    }
+    const size_t result_size = a.size() + b.size() - 1;
+    std::vector<ValueT> result = cyclic_multiply(a, b, (size_t)1 << log2_ceil(result_size));
+    result.resize(result_size, ValueT::zero());
+    return result;
+}
+
+template <typename FieldT>
+std::vector<FieldT> inverse_series(std::vector<FieldT> const &f, size_t size)
+{
+    // Newton iteration, doubling the precision of g each round: g' = g.(2 - f.g).
+    std::vector<FieldT> g(1, f[0].inverse());
+    for (size_t precision = 1; precision < size;)
+    {
+        precision = std::min(2 * precision, size);
+        std::vector<FieldT> f_low(f.begin(), f.begin() + std::min(precision, f.size()));
+        std::vector<FieldT> correction = multiply(f_low, g);
+        correction.resize(precision, FieldT::zero());
+        for (auto &coefficient : correction)
+        {
+            coefficient = -coefficient;
+        }
+        correction[0] = correction[0] + FieldT(2);
+        g = multiply(correction, g);
+        g.resize(precision, FieldT::zero());
+    }
+    return g;
+}
+
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> remainder(std::vector<ValueT> const &p, std::vector<FieldT> const &m)
+{
+    const size_t degree = m.size() - 1;
+    if (p.size() <= degree)
+    {
+        return p;
+    }
+
+    // Reversing the coefficients of p = m.q + r gives rev(p) = rev(m).rev(q) mod X^(deg p - deg m + 1), as r's terms
+    // land above that.
+    const size_t q_size = p.size() - degree;
+    std::vector<FieldT> m_inverse = inverse_series(std::vector<FieldT>(m.rbegin(), m.rend()), q_size);
+    std::vector<ValueT> q = multiply(m_inverse, std::vector<ValueT>(p.rbegin(), p.rbegin() + q_size));
+    q.resize(q_size, ValueT::zero());
+    std::reverse(q.begin(), q.end());
+
+    // r = p - m.q has degree below m's, so only its product mod (X^size - 1), for size at least that, is needed.
+    const size_t size = (size_t)1 << log2_ceil(degree);
+    std::vector<ValueT> mq = cyclic_multiply(m, q, size);
+    std::vector<ValueT> r(size, ValueT::zero());
+    for (size_t i = 0; i < p.size(); ++i)
+    {
+        r[i % size] = r[i % size] + p[i];
+    }
+    for (size_t i = 0; i < degree; ++i)
+    {
+        r[i] = r[i] - mq[i];
+    }
+    r.resize(degree, ValueT::zero());
+    return r;
+}
+
+template <typename FieldT>
+std::vector<FieldT> subproduct(size_t first, size_t last)
+{
+    if (last <= first)
+    {
+        return std::vector<FieldT>(1, FieldT::one());
+    }
+    if (last - first == 1)
+    {
+        return { -FieldT((long)first), FieldT::one() };
+    }
+    const size_t mid = first + (last - first) / 2;
+    return multiply(subproduct<FieldT>(first, mid), subproduct<FieldT>(mid, last));
+}
+
+template <typename FieldT, typename ValueT>
+std::vector<ValueT> evaluate(std::vector<ValueT> const &p, size_t num_points)
+{
+    // Each node of the tree holds the remainder of p by the subproduct of its points, which agrees with p on them.
+    struct Node
+    {
+        size_t first = 0;
+        size_t last = 0;
+        std::vector<ValueT> polynomial;
+    };
+
+    std::vector<ValueT> values(num_points, ValueT::zero());
+    std::vector<Node> level(1);
+    level[0] = { 0, num_points, p.size() > num_points ? remainder(p, subproduct<FieldT>(0, num_points)) : p };
+
+    // A level at a time, so that the few large nodes near the root share out their FFTs across the thread pool, and
+    // the many small ones below run a node per task. Only two levels of remainders are held at once.
+    while (!level.empty())
+    {
+        std::vector<Node> children(2 * level.size());
+        parallel::parallel_for(level.size(), [&](size_t i) {
+            Node &node = level[i];
+            if (node.last - node.first <= LEAF_POINTS)
+            {
+                for (size_t point = node.first; point < node.last; ++point)
+                {
+                    // Horner's rule.
+                    const FieldT x((long)point);
+                    ValueT value = ValueT::zero();
+                    for (size_t j = node.polynomial.size(); j-- > 0;)
+                    {
+                        value = x * value + node.polynomial[j];
+                    }
+                    values[point] = value;
+                }
+            }
+            else
+            {
+                const size_t mid = node.first + (node.last - node.first) / 2;
+                children[2 * i] = { node.first, mid, remainder(node.polynomial, subproduct<FieldT>(node.first, mid)) };
+                children[2 * i + 1] = { mid, node.last, remainder(node.polynomial, subproduct<FieldT>(mid, node.last)) };
+            }
+            std::vector<ValueT>().swap(node.polynomial);
+        });
+
+        level.clear();
+        for (auto &child : children)
+        {
+            if (child.last > child.first)
+            {
+                level.push_back(std::move(child));
+            }
+        }
+    }
+    return values;
+}
+
+template <typename FieldT, typename GroupT>
+std::vector<GroupT> compute_range_points(std::vector<FieldT> const &generator_polynomial, GroupT const *powers_of_x)
+{
+    const size_t num_points = generator_polynomial.size() - 1;
+
+    // H_m is the coefficient of X^(n - 1 - m), for n = num_points, of the product of c_n + c_(n - 1).X + ... +
+    // c_1.X^(n - 1) with g_0 + g_1.X + ... + g_(n - 1).X^(n - 1).
+    std::vector<FieldT> reversed(generator_polynomial.rbegin(), generator_polynomial.rend() - 1);
+    std::vector<GroupT> product = multiply(reversed, std::vector<GroupT>(powers_of_x, powers_of_x + num_points));
+    std::vector<GroupT> h(product.rend() - num_points, product.rend());
+    std::vector<GroupT>().swap(product);
+
+    return evaluate<FieldT>(h, num_points);
+}
+
+} // namespace range_fft
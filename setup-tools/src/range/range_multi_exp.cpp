@@ -3,13 +3,19 @@
  * Copyright Spilsbury Holdings 2019
  **/
 #include "range_multi_exp.hpp"
+#include "range_fft.hpp"
 
 #include <aztec_common/assert.hpp>
+#include <aztec_common/batch_normalize.hpp>
+#include <aztec_common/libff_types.hpp>
+#include <aztec_common/pippenger_bberg.hpp>
+#include <aztec_common/streaming_range.hpp>
 #include <aztec_common/streaming_transcript.hpp>
+#include <aztec_common/thread_pool.hpp>
 #include <aztec_common/timer.hpp>
 
-#include <barretenberg/groups/scalar_multiplication.hpp>
-
+#include <fstream>
+#include <memory>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -21,7 +27,7 @@ void *map_file(std::string const &filename)
     assert(fd != -1);
 
     struct stat sb;
-    if (fstat(fd, &sb) != -1)
+    if (fstat(fd, &sb) == -1)
     {
         assert(false);
     }
@@ -33,59 +39,160 @@ void *map_file(std::string const &filename)
     return data;
 }
 
-bb::g1::element process_range_zero(bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num)
+bb::g1::element process_range_zero(bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num, fixed_base::Table const *table)
 {
-    // Scalars are mutated, so copy them first.
-    auto range_coefficients = std::vector<bb::fr::field_t>(num);
-    memcpy(&range_coefficients[0], generator_coefficients + 1 + start, num * sizeof(bb::fr::field_t));
-    return bb::scalar_multiplication::pippenger_low_memory(&range_coefficients[0], powers_of_x + start, num);
+    if (table)
+    {
+        return fixed_base::multi_exp(*table, start, generator_coefficients + 1 + start, num);
+    }
+
+    // Scalars are mutated, so each thread copies its share first.
+    return pippenger::multi_exp_bberg(powers_of_x + start, generator_coefficients + 1 + start, num, true);
 }
 
-bb::g1::element process_range_single(int range_index, bb::fr::field_t &fa, bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num)
+bb::g1::element process_range_single(int range_index, bb::fr::field_t &fa, bb::g1::affine_element *const &powers_of_x, bb::fr::field_t *const &generator_coefficients, size_t start, size_t num, std::vector<bb::fr::field_t> &range_coefficients, fixed_base::Table const *table)
 {
-    std::vector<bb::fr::field_t> range_coefficients(num);
+    // With more batches than points, all but the last are empty, and leave fa as it is.
+    if (num == 0)
+    {
+        bb::g1::element result = {.x = {0}, .y = {0}, .z = {0}};
+        bb::g1::set_infinity(result);
+        return result;
+    }
+
+    range_coefficients.resize(num);
 
     bb::fr::field_t divisor;
     bb::fr::to_montgomery_form({(uint64_t)range_index, 0, 0, 0}, divisor);
     bb::fr::neg(divisor, divisor);
     divisor = bb::fr::invert(divisor);
 
-    range_coefficients[0] = bb::fr::mul(bb::fr::sub(generator_coefficients[start], fa), divisor);
-    for (size_t i = 1; i < num; ++i)
+    // Each coefficient is (generator_coefficients[start + i] - previous).divisor, affine in the previous one, so they
+    // are computed as a blocked scan, a block per chunk of the multi-exponentiation. Each block first runs the
+    // recurrence from zero. Given the coefficient c before a block, its jth coefficient is then off by
+    // divisor.(-divisor)^j.c.
+    const size_t num_blocks = pippenger::multi_exp_bberg_chunks(num);
+    bb::fr::field_t ratio;
+    bb::fr::neg(divisor, ratio);
+    std::vector<bb::fr::field_t> last_offsets(num_blocks);
+    parallel::parallel_for(num_blocks, [&](size_t block) {
+        const size_t block_start = block * num / num_blocks;
+        const size_t block_end = (block + 1) * num / num_blocks;
+        bb::fr::field_t previous = bb::fr::zero();
+        bb::fr::field_t offset = divisor;
+        for (size_t i = block_start; i < block_end; ++i)
+        {
+            if (i != block_start)
+            {
+                offset = bb::fr::mul(offset, ratio);
+            }
+            previous = range_coefficients[i] = bb::fr::mul(bb::fr::sub(generator_coefficients[start + i], previous), divisor);
+        }
+        last_offsets[block] = offset;
+    });
+
+    // The coefficient before each block, from the last of the one before it.
+    std::vector<bb::fr::field_t> carries(num_blocks);
+    for (size_t block = 0; block < num_blocks; ++block)
     {
-        range_coefficients[i] = bb::fr::mul(bb::fr::sub(generator_coefficients[start + i], range_coefficients[i - 1]), divisor);
+        carries[block] = fa;
+        const size_t block_end = (block + 1) * num / num_blocks;
+        fa = bb::fr::sub(range_coefficients[block_end - 1], bb::fr::mul(last_offsets[block], fa));
     }
 
-    fa = range_coefficients.back();
+    // Each block is corrected by the task that multi-exponentiates it, overlapping with the other blocks.
+    auto correct_block = [&](size_t block, size_t block_start, size_t block_end) {
+        bb::fr::field_t offset = bb::fr::mul(divisor, carries[block]);
+        for (size_t i = block_start; i < block_end; ++i)
+        {
+            range_coefficients[i] = bb::fr::sub(range_coefficients[i], offset);
+            offset = bb::fr::mul(offset, ratio);
+        }
+    };
+    return table ? fixed_base::multi_exp(*table, start, &range_coefficients[0], num, correct_block)
+                 : pippenger::multi_exp_bberg(powers_of_x + start, &range_coefficients[0], num, false, correct_block);
+}
 
-    return bb::scalar_multiplication::pippenger_low_memory(&range_coefficients[0], powers_of_x + start, num);
+bb::g1::element process_range(int range_index, bb::fr::field_t &fa, bb::g1::affine_element *const powers_of_x, bb::fr::field_t *const generator_coefficients, size_t start, size_t num, std::vector<bb::fr::field_t> &scratch, fixed_base::Table const *table)
+{
+    return range_index == 0
+               ? process_range_zero(powers_of_x, generator_coefficients, start, num, table)
+               : process_range_single(range_index, fa, powers_of_x, generator_coefficients, start, num, scratch, table);
 }
 
 bb::g1::element process_range(int range_index, bb::fr::field_t &fa, bb::g1::affine_element *const powers_of_x, bb::fr::field_t *const generator_coefficients, size_t start, size_t num)
 {
-    return range_index == 0
-               ? process_range_zero(powers_of_x, generator_coefficients, start, num)
-               : process_range_single(range_index, fa, powers_of_x, generator_coefficients, start, num);
+    std::vector<bb::fr::field_t> scratch;
+    return process_range(range_index, fa, powers_of_x, generator_coefficients, start, num, scratch);
 }
 
 bb::g1::element batch_process_range(size_t range_index, size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial)
+{
+    std::vector<bb::fr::field_t> scratch;
+    return batch_process_range(range_index, polynomial_degree, batch_num, g1_x, generator_polynomial, scratch);
+}
+
+bb::g1::element batch_process_range(size_t range_index, size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial, std::vector<bb::fr::field_t> &scratch, fixed_base::Table const *table)
 {
     size_t batch_size = polynomial_degree / batch_num;
-    size_t leftovers = polynomial_degree % batch_size;
+    size_t leftovers = polynomial_degree % batch_num;
     bb::fr::field_t fa = bb::fr::zero();
 
     bb::g1::element result = {.x = {0}, .y = {0}, .z = {0}};
     bb::g1::set_infinity(result);
     for (size_t i = 0; i < batch_num; ++i)
     {
-        auto r = process_range(range_index, fa, g1_x, generator_polynomial, batch_size * i, (i == batch_num - 1) ? batch_size + leftovers : batch_size);
+        auto r = process_range(range_index, fa, g1_x, generator_polynomial, batch_size * i, (i == batch_num - 1) ? batch_size + leftovers : batch_size, scratch, table);
         bb::g1::add(r, result, result);
     }
 
     return result;
 }
 
-void compute_range_polynomials(std::string const &generator_path, std::string const &g1x_path, size_t range_index, size_t polynomial_degree, size_t batches)
+namespace
+{
+
+void print_point(bb::g1::element const &point)
+{
+    bb::g1::affine_element r;
+    bb::g1::jacobian_to_affine(point, r);
+    bb::fq::from_montgomery_form(r.x, r.x);
+    bb::fq::from_montgomery_form(r.y, r.y);
+    gmp_printf("[\"0x%064Nx\",\"0x%064Nx\"]", r.x.data, 4L, r.y.data, 4L);
+}
+
+// Compressed as the range proof publisher does: x, big endian, with the top bit set if y is odd. point is affine.
+void write_compressed_point(std::ostream &file, G1 const &point)
+{
+    auto x = point.X.as_bigint();
+    constexpr size_t num_limbs = sizeof(x.data) / sizeof(x.data[0]);
+    if (point.Y.as_bigint().test_bit(0))
+    {
+        x.data[num_limbs - 1] |= (mp_limb_t)1 << (GMP_NUMB_BITS - 1);
+    }
+    mp_limb_t buffer[num_limbs];
+    for (size_t i = 0; i < num_limbs; ++i)
+    {
+        buffer[i] = __builtin_bswap64(x.data[num_limbs - 1 - i]);
+    }
+    file.write((char *)buffer, sizeof(buffer));
+}
+
+// Maps the fixed-base table at table_path, if any, checking that it is of the first polynomial_degree points of g1_x.
+std::unique_ptr<fixed_base::Table> load_table(std::string const &table_path, bb::g1::affine_element const *g1_x, size_t polynomial_degree)
+{
+    if (table_path.empty())
+    {
+        return nullptr;
+    }
+    std::unique_ptr<fixed_base::Table> table(new fixed_base::Table(fixed_base::map_table(table_path)));
+    fixed_base::check_table(*table, g1_x, polynomial_degree);
+    return table;
+}
+
+} // namespace
+
+void compute_range_polynomials(std::string const &generator_path, std::string const &g1x_path, size_t range_index, size_t polynomial_degree, size_t batches, std::string const &table_path)
 {
     Timer total_timer;
 
@@ -93,17 +200,92 @@ void compute_range_polynomials(std::string const &generator_path, std::string co
     Timer data_timer;
     bb::fr::field_t *generator_coefficients = (bb::fr::field_t *)map_file(generator_path);
     bb::g1::affine_element *g1_x = (bb::g1::affine_element *)map_file(g1x_path);
+    std::unique_ptr<fixed_base::Table> table = load_table(table_path, g1_x, polynomial_degree);
     std::cerr << "Loaded in " << data_timer.toString() << "s" << std::endl;
 
     Timer compute_timer;
-    bb::g1::element result = batch_process_range(range_index, polynomial_degree, batches, g1_x, generator_coefficients);
+    std::vector<bb::fr::field_t> scratch;
+    bb::g1::element result = batch_process_range(range_index, polynomial_degree, batches, g1_x, generator_coefficients, scratch, table.get());
 
     std::cerr << "Compute time: " << compute_timer.toString() << "s" << std::endl;
     std::cerr << "Total time: " << total_timer.toString() << "s" << std::endl;
 
-    bb::g1::affine_element r;
-    bb::g1::jacobian_to_affine(result, r);
-    bb::fq::from_montgomery_form(r.x, r.x);
-    bb::fq::from_montgomery_form(r.y, r.y);
-    gmp_printf("[\"0x%064Nx\",\"0x%064Nx\"]\n", r.x.data, 4L, r.y.data, 4L);
+    print_point(result);
+    gmp_printf("\n");
+}
+
+void compute_range_polynomials(std::string const &generator_path, std::string const &g1x_path, std::function<bool(size_t &)> const &next_index, size_t polynomial_degree, size_t batches, std::string const &table_path)
+{
+    Timer total_timer;
+
+    std::cerr << "Loading data..." << std::endl;
+    Timer data_timer;
+    bb::fr::field_t *generator_coefficients = (bb::fr::field_t *)map_file(generator_path);
+    bb::g1::affine_element *g1_x = (bb::g1::affine_element *)map_file(g1x_path);
+    std::unique_ptr<fixed_base::Table> table = load_table(table_path, g1_x, polynomial_degree);
+    std::cerr << "Loaded in " << data_timer.toString() << "s" << std::endl;
+
+    // The mappings stay warm, and the scalar buffer allocated, from one index to the next.
+    std::vector<bb::fr::field_t> scratch;
+    size_t num_computed = 0;
+    for (size_t range_index; next_index(range_index); ++num_computed)
+    {
+        bb::g1::element result = batch_process_range(range_index, polynomial_degree, batches, g1_x, generator_coefficients, scratch, table.get());
+        gmp_printf("%zu ", range_index);
+        print_point(result);
+        gmp_printf("\n");
+        fflush(stdout);
+    }
+
+    std::cerr << "Computed " << num_computed << " points." << std::endl;
+    std::cerr << "Total time: " << total_timer.toString() << "s" << std::endl;
+}
+
+void compute_all_range_polynomials(std::string const &generator_path, std::string const &g1x_path, size_t polynomial_degree, std::string const &output_path)
+{
+    Timer total_timer;
+    libff::init_alt_bn128_params();
+
+    std::cerr << "Loading data..." << std::endl;
+    Timer data_timer;
+    Fr *generator_coefficients = (Fr *)map_file(generator_path);
+    bb::g1::affine_element *g1_x = (bb::g1::affine_element *)map_file(g1x_path);
+
+    // Both libraries hold field elements in Montgomery form with the same modulus, so coordinates copy over as is.
+    std::vector<Fr> generator_polynomial(generator_coefficients, generator_coefficients + polynomial_degree + 1);
+    std::vector<G1> powers_of_x(polynomial_degree);
+    parallel::parallel_for(polynomial_degree, [&](size_t i) {
+        Fq x, y;
+        memcpy(&x.mont_repr.data[0], &g1_x[i].x.data[0], sizeof(x.mont_repr.data));
+        memcpy(&y.mont_repr.data[0], &g1_x[i].y.data[0], sizeof(y.mont_repr.data));
+        powers_of_x[i] = G1(x, y, Fq::one());
+    });
+    std::cerr << "Loaded in " << data_timer.toString() << "s" << std::endl;
+
+    Timer compute_timer;
+    std::vector<G1> points = range_fft::compute_range_points(generator_polynomial, &powers_of_x[0]);
+    std::cerr << "Compute time: " << compute_timer.toString() << "s" << std::endl;
+
+    const size_t num_files = (polynomial_degree + POINTS_PER_RANGE_FILE - 1) / POINTS_PER_RANGE_FILE;
+    parallel::parallel_for(num_files, [&](size_t file) {
+        const size_t start = file * POINTS_PER_RANGE_FILE;
+        batch_normalize::batch_normalize<Fq, G1>(start, std::min(POINTS_PER_RANGE_FILE, polynomial_degree - start), &points[0]);
+    });
+
+    std::cerr << "Writing " << points.size() << " points to " << output_path << "..." << std::endl;
+    for (size_t start = 0; start < polynomial_degree; start += POINTS_PER_RANGE_FILE)
+    {
+        const std::string filename = output_path + "data" + std::to_string(start) + ".dat";
+        std::ofstream file(filename, std::ios::binary);
+        for (size_t i = start; i < std::min(start + POINTS_PER_RANGE_FILE, polynomial_degree); ++i)
+        {
+            write_compressed_point(file, points[i]);
+        }
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write " + filename);
+        }
+    }
+
+    std::cerr << "Total time: " << total_timer.toString() << "s" << std::endl;
 }
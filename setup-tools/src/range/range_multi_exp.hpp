@@ -4,14 +4,36 @@
  **/
 #pragma once
 
+#include <functional>
 #include <string>
+#include <vector>
 #include <barretenberg/fields/fr.hpp>
 #include <barretenberg/groups/g1.hpp>
+#include <aztec_common/fixed_base_bberg.hpp>
 
 namespace bb = barretenberg;
 
 bb::g1::element process_range(int range_index, bb::fr::field_t &fa, bb::g1::affine_element *const powers_of_x, bb::fr::field_t *const generator_coefficients, size_t start, size_t num);
 
+// As above, with the batch's scalars in scratch, which is grown as needed. Given a table of powers_of_x (see
+// fixed_base_bberg.hpp), the multi-exponentiation runs against it instead.
+bb::g1::element process_range(int range_index, bb::fr::field_t &fa, bb::g1::affine_element *const powers_of_x, bb::fr::field_t *const generator_coefficients, size_t start, size_t num, std::vector<bb::fr::field_t> &scratch, fixed_base::Table const *table = nullptr);
+
 bb::g1::element batch_process_range(size_t range_index, size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial);
 
-void compute_range_polynomials(std::string const &generator_path, std::string const &g1x_path, size_t range_index, size_t polynomial_degree, size_t batches);
\ No newline at end of file
+// As above, reusing scratch for the scalars of every batch, so that computing many indices allocates them once, and
+// multi-exponentiating against table if given.
+bb::g1::element batch_process_range(size_t range_index, size_t polynomial_degree, size_t batch_num, bb::g1::affine_element *const &g1_x, bb::fr::field_t *const &generator_polynomial, std::vector<bb::fr::field_t> &scratch, fixed_base::Table const *table = nullptr);
+
+// With table_path, the fixed-base table of g1x written by prep_range_data --fixed-base is mapped and used.
+void compute_range_polynomials(std::string const &generator_path, std::string const &g1x_path, size_t range_index, size_t polynomial_degree, size_t batches, std::string const &table_path = std::string());
+
+// Computes the point of every index next_index yields, until it returns false, and prints a line for each as it
+// completes: the index, then the point. The data is mapped once for all of them.
+void compute_range_polynomials(std::string const &generator_path, std::string const &g1x_path, std::function<bool(size_t &)> const &next_index, size_t polynomial_degree, size_t batches, std::string const &table_path = std::string());
+
+// Computes the points of every index below polynomial_degree in one pass (see range_fft.hpp), and writes them to files
+// of POINTS_PER_RANGE_FILE (1000) compressed points each, named output_path + "data<first index>.dat", the layout
+// streaming::read_file and verify_range_points read. This is not the server's rangeProofsPerFile, which defaults to
+// 1024.
+void compute_all_range_polynomials(std::string const &generator_path, std::string const &g1x_path, size_t polynomial_degree, std::string const &output_path);
@@ -0,0 +1,40 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <aztec_common/transcript_reshard.hpp>
+
+int main(int argc, char **argv)
+{
+    if (argc < 4 || argc > 5)
+    {
+        std::cout << "usage: " << argv[0] << " <input dir> <output dir> <points per transcript> [<max points>]" << std::endl;
+        return 1;
+    }
+    std::string const input_dir(argv[1]);
+    std::string const output_dir(argv[2]);
+    size_t const points_per_transcript = strtoul(argv[3], NULL, 0);
+    size_t const max_points = argc == 5 ? strtoul(argv[4], NULL, 0) : std::numeric_limits<size_t>::max();
+
+    try
+    {
+        auto set = streaming::find_transcripts(input_dir);
+        std::cout << "Found " << set.size() << " transcripts holding " << set.num_g1_points() << " G1 points." << std::endl;
+
+        mkdir(output_dir.c_str(), 0755);
+        std::cout << "Validating and resharding..." << std::endl;
+        auto manifests = streaming::reshard_transcripts(set, output_dir, points_per_transcript, max_points);
+
+        std::cout << "Wrote " << manifests.size() << " transcripts holding " << manifests[0].total_g1_points
+                  << " G1 points and " << manifests[0].total_g2_points << " G2 points." << std::endl;
+        return 0;
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
@@ -12,12 +12,23 @@
 
 int main(int argc, char **argv)
 {
-    if (argc < 2 || argc > 4)
+    // An optional leading --ledger <path> lets verified transcripts load without per-point checks.
+    std::string ledger_path;
+    int first_arg = 1;
+    if (argc > 2 && std::string(argv[1]) == "--ledger")
     {
-        std::cerr << "usage: " << argv[0] << " <transcript dir> [<initial num g1 points> <initial num g2 points>]" << std::endl;
+        ledger_path = argv[2];
+        first_arg = 3;
+    }
+    char **args = argv + first_arg;
+    int num_args = argc - first_arg;
+
+    if (num_args < 1 || num_args > 3)
+    {
+        std::cerr << "usage: " << argv[0] << " [--ledger <ledger path>] <transcript dir> [<initial num g1 points> <initial num g2 points>]" << std::endl;
         return 1;
     }
-    std::string const dir = argv[1];
+    std::string const dir = args[0];
 
     libff::alt_bn128_pp::init_public_params();
 
@@ -28,12 +39,16 @@ int main(int argc, char **argv)
         {
             throw std::runtime_error("Transcript directory not found.");
         }
+        if (!ledger_path.empty())
+        {
+            use_transcript_ledger(ledger_path);
+        }
 
 #ifdef SEALING
         seal(dir);
 #else
-        size_t num_g1_points = (argc >= 3) ? strtol(argv[2], NULL, 0) : 0;
-        size_t num_g2_points = (argc == 4) ? strtol(argv[3], NULL, 0) : 1;
+        size_t num_g1_points = (num_args >= 2) ? strtol(args[1], NULL, 0) : 0;
+        size_t num_g2_points = (num_args == 3) ? strtol(args[2], NULL, 0) : 1;
 
         run_setup(dir, num_g1_points, num_g2_points);
 #endif
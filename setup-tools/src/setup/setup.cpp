@@ -8,11 +8,15 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <future>
+#include <memory>
 #include <unistd.h>
 #ifdef __linux__
 #include <pthread.h>
 #endif
 #include <aztec_common/streaming_transcript.hpp>
+#include <aztec_common/transcript_ledger.hpp>
+#include <aztec_common/transcript_set.hpp>
 
 #include "utils.hpp"
 
@@ -173,29 +177,82 @@ size_t calculate_current_progress(streaming::Manifest const &manifest)
     return g1_points * G1_WEIGHT + g2_points * G2_WEIGHT;
 }
 
-// Given an existing transcript file, read it and start computation.
-void compute_existing_transcript(std::string const &dir, size_t num, Fr &multiplicand, size_t &progress)
+struct ExistingTranscript
 {
     streaming::Manifest manifest;
     std::vector<G1> g1_x;
     std::vector<G2> g2_x;
+};
 
-    std::cerr << "Reading transcript..." << std::endl;
-    std::string const filename = getTranscriptInPath(dir, num);
-    streaming::read_transcript(g1_x, g2_x, manifest, filename);
+// Transcripts this ledger records as verified are loaded without per-point curve checks.
+std::unique_ptr<streaming::TranscriptLedger> trusted_ledger;
+
+void use_transcript_ledger(std::string const &path)
+{
+    trusted_ledger.reset(new streaming::TranscriptLedger(path));
+}
+
+ExistingTranscript read_existing_transcript(std::string const &filename, size_t num)
+{
+    ExistingTranscript transcript;
+    if (trusted_ledger)
+    {
+        streaming::read_trusted_transcript(transcript.g1_x, transcript.g2_x, transcript.manifest, filename, *trusted_ledger);
+    }
+    else
+    {
+        streaming::read_transcript(transcript.g1_x, transcript.g2_x, transcript.manifest, filename);
+    }
 
     if (num == 0)
     {
         // Discard the additional g2^y point in transcript 0. This is only used for verification.
-        g2_x.pop_back();
-        manifest.num_g2_points -= 1;
+        transcript.g2_x.pop_back();
+        transcript.manifest.num_g2_points -= 1;
     }
+    return transcript;
+}
 
+void compute_read_transcript(std::string const &dir, ExistingTranscript &transcript, Fr &multiplicand, size_t &progress)
+{
+    streaming::Manifest &manifest = transcript.manifest;
     progress = calculate_current_progress(manifest);
 
     std::cerr << "Will compute " << manifest.num_g1_points << " G1 points and " << manifest.num_g2_points << " G2 points on top of transcript " << manifest.transcript_number << std::endl;
 
-    compute_transcript(dir, g1_x, g2_x, manifest, multiplicand, progress);
+    compute_transcript(dir, transcript.g1_x, transcript.g2_x, manifest, multiplicand, progress);
+}
+
+// Given an existing transcript file, read it and start computation.
+void compute_existing_transcript(std::string const &dir, size_t num, Fr &multiplicand, size_t &progress)
+{
+    std::cerr << "Reading transcript..." << std::endl;
+    ExistingTranscript transcript = read_existing_transcript(getTranscriptInPath(dir, num), num);
+    compute_read_transcript(dir, transcript, multiplicand, progress);
+}
+
+// Computes on top of every transcript in dir in turn. The next transcript is read in the background while the
+// current one computes, so at most two are held in memory at once.
+void compute_existing_transcripts(std::string const &dir, Fr &multiplicand, size_t &progress)
+{
+    if (!streaming::is_file_exist(getTranscriptInPath(dir, 0)))
+    {
+        std::cerr << "No input files found." << std::endl;
+        return;
+    }
+
+    streaming::TranscriptSet set = streaming::find_transcripts(dir);
+    std::future<ExistingTranscript> next = std::async(std::launch::async, read_existing_transcript, set.paths[0], 0);
+    for (size_t num = 0; num < set.size(); ++num)
+    {
+        std::cerr << "Reading transcript..." << std::endl;
+        ExistingTranscript transcript = next.get();
+        if (num + 1 < set.size())
+        {
+            next = std::async(std::launch::async, read_existing_transcript, set.paths[num + 1], num + 1);
+        }
+        compute_read_transcript(dir, transcript, multiplicand, progress);
+    }
 }
 
 // Computes initial transcripts.
@@ -312,18 +369,7 @@ void auto_run(std::string const &dir, Secret<Fr> &multiplicand, size_t num_g1_po
     }
     else
     {
-        size_t num = 0;
-        std::string filename = getTranscriptInPath(dir, num);
-        while (streaming::is_file_exist(filename))
-        {
-            compute_existing_transcript(dir, num, multiplicand, progress);
-            filename = getTranscriptInPath(dir, ++num);
-        }
-
-        if (num == 0)
-        {
-            std::cerr << "No input files found." << std::endl;
-        }
+        compute_existing_transcripts(dir, multiplicand, progress);
     }
 
     std::cerr << "Done." << std::endl;
@@ -354,13 +400,10 @@ void run_setup(std::string const &dir, size_t num_g1_points, size_t num_g2_point
 Fr generate_sealing_multiplicand(std::string const &dir)
 {
     std::vector<char> checksums;
-    size_t num = 0;
-    std::string filename = getTranscriptInPath(dir, num);
-    while (streaming::is_file_exist(filename))
+    auto transcript_checksums = streaming::read_transcript_checksums(streaming::find_transcripts(dir));
+    for (auto const &transcript_checksum : transcript_checksums)
     {
-        std::vector<char> checksum = streaming::read_checksum(filename);
-        checksums.insert(checksums.end(), checksum.begin(), checksum.end());
-        filename = getTranscriptInPath(dir, ++num);
+        checksums.insert(checksums.end(), transcript_checksum.begin(), transcript_checksum.end());
     }
     char checksum_of_checksums[checksum::BLAKE2B_CHECKSUM_LENGTH] = {0};
     checksum::create_checksum(&checksums[0], checksums.size(), &checksum_of_checksums[0]);
@@ -381,17 +424,6 @@ void seal(std::string const &dir)
     multiplicand.print();
 
     size_t progress = 0;
-    size_t num = 0;
-    std::string filename = getTranscriptInPath(dir, num);
-    while (streaming::is_file_exist(filename))
-    {
-        compute_existing_transcript(dir, num, multiplicand, progress);
-        filename = getTranscriptInPath(dir, ++num);
-    }
-
-    if (num == 0)
-    {
-        std::cerr << "No input files found." << std::endl;
-    }
+    compute_existing_transcripts(dir, multiplicand, progress);
 }
 #endif
\ No newline at end of file
@@ -9,6 +9,9 @@
 
 void compute_g1_thread(Fr const &_y, std::vector<G1> &g_x, size_t transcript_start, size_t thread_start, size_t thread_range, std::atomic<size_t> &progress);
 
+// Loads existing transcripts that the ledger at path records as verified without re-checking every point.
+void use_transcript_ledger(std::string const &path);
+
 void run_setup(std::string const &dir, size_t num_g1_points, size_t num_g2_points);
 
 #ifdef SEALING
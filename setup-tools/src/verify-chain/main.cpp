@@ -0,0 +1,94 @@
+/**
+ * Setup
+ * Copyright Spilsbury Holdings 2019
+ **/
+#include <verify/verifier.hpp>
+
+void print_usage(char const *name)
+{
+    std::cout << "usage: " << name << " [--small-exponents] [--window <points>] [--previous <transcript 0 path>] <total G1 points> <total G2 points> <points per transcript> <participant transcript dir>..." << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    // --previous <path> checks the first participant was derived from the transcript 0 of the participant before it.
+    // --small-exponents and --window are as for verify.
+    std::string previous_transcript0_path;
+    bool small_exponents = false;
+    size_t window_points = DEFAULT_WINDOW_POINTS;
+    int first_arg = 1;
+    while (first_arg < argc)
+    {
+        std::string const option(argv[first_arg]);
+        if (option == "--previous" && first_arg + 1 < argc)
+        {
+            previous_transcript0_path = argv[first_arg + 1];
+            first_arg += 2;
+        }
+        else if (option == "--window" && first_arg + 1 < argc)
+        {
+            window_points = strtol(argv[first_arg + 1], NULL, 0);
+            first_arg += 2;
+        }
+        else if (option == "--small-exponents")
+        {
+            small_exponents = true;
+            ++first_arg;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc - first_arg < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    char **args = argv + first_arg;
+    size_t const total_g1_points = strtol(args[0], NULL, 0);
+    size_t const total_g2_points = strtol(args[1], NULL, 0);
+    size_t const points_per_transcript = strtol(args[2], NULL, 0);
+    std::vector<std::string> const dirs(args + 3, argv + argc);
+
+    libff::alt_bn128_pp::init_public_params();
+
+    if (!previous_transcript0_path.empty() && !streaming::is_file_exist(previous_transcript0_path))
+    {
+        std::cout << "Previous transcript not found: " << previous_transcript0_path << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        // The participants' manifests are all checked before any points are read.
+        std::vector<streaming::TranscriptSet> sets;
+        for (size_t p = 0; p < dirs.size(); ++p)
+        {
+            try
+            {
+                sets.push_back(streaming::find_transcripts(dirs[p]));
+                for (size_t i = 0; i < sets.back().size(); ++i)
+                {
+                    validate_manifest(sets.back().manifests[i], total_g1_points, total_g2_points, points_per_transcript, i);
+                }
+            }
+            catch (std::exception const &err)
+            {
+                throw std::runtime_error("Participant " + std::to_string(p) + " (" + dirs[p] + "): " + err.what());
+            }
+        }
+        std::cout << "Found " << sets.size() << " participants." << std::endl;
+
+        verify_chain(sets, previous_transcript0_path, window_points, small_exponents);
+
+        std::cout << "Chain valid." << std::endl;
+        return 0;
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
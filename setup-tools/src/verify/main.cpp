@@ -3,30 +3,143 @@
  * Copyright Spilsbury Holdings 2019
  **/
 #include "verifier.hpp"
+#include <aztec_common/transcript_ledger.hpp>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
-int main(int argc, char **argv)
+void print_usage(char const *name)
+{
+    std::cout << "usage: " << name << " [--ledger <ledger path>] [--staged] [--small-exponents] [--window <points>] <total G1 points> <total G2 points> <points per transcript> <transcript num> <transcript path> [<transcript 0 path> <previous transcript path>]" << std::endl;
+    std::cout << "       " << name << " --all [--small-exponents] [--window <points>] <total G1 points> <total G2 points> <points per transcript> <transcript dir> [<previous transcript 0 path>]" << std::endl;
+    std::cout << "       " << name << " --follow [--small-exponents] [--window <points>] <total G1 points> <total G2 points> <points per transcript> <transcript num> <transcript path | -> [<transcript 0 path> <previous transcript path>]" << std::endl;
+    std::cout << "       " << name << " --daemon [--jobs <num>] [--staged] [--small-exponents] [--window <points>]" << std::endl;
+    std::cout << "       " << name << " --partial <seed> [--small-exponents] [--window <points>] <first point> <num points> <transcript path>" << std::endl;
+    std::cout << "       " << name << " --combine <seed> [--small-exponents] <total G1 points> <total G2 points> <points per transcript> <transcript num> <transcript path> [<transcript 0 path> <previous transcript path>] < <partials>" << std::endl;
+}
+
+// Runs one daemon command, and returns the response line:
+//   verify <id> <total G1 points> <total G2 points> <points per transcript> <transcript num> <transcript path> [<transcript 0 path> <previous transcript path>]
+// answers "<id> valid", or "<id> invalid <reason>".
+std::string process_command(VerifierCache &cache, std::string const &line, size_t window_points, bool small_exponents, size_t prefix_points)
 {
-    if (argc < 6)
+    std::istringstream iss(line);
+    std::string cmd, id;
+    iss >> cmd >> id;
+    if (cmd != "verify" || id.empty())
     {
-        std::cout << "usage: " << argv[0] << " <total G1 points> <total G2 points> <points per transcript> <transcript num> <transcript path> [<transcript 0 path> <previous transcript path>]" << std::endl;
-        return 1;
+        return "error Unknown command: " + line;
     }
-    size_t const total_g1_points = strtol(argv[1], NULL, 0);
-    size_t const total_g2_points = strtol(argv[2], NULL, 0);
-    size_t const points_per_transcript = strtol(argv[3], NULL, 0);
-    size_t const transcript_num = strtol(argv[4], NULL, 0);
-    std::string const transcript_path(argv[5]);
-    std::string const transcript0_path(argc == 6 ? argv[5] : argv[6]);
-    std::string const transcript_previous_path(argc > 7 ? argv[7] : "");
 
+    size_t total_g1_points, total_g2_points, points_per_transcript, transcript_num;
+    std::string transcript_path, transcript0_path, transcript_previous_path;
+    if (!(iss >> total_g1_points >> total_g2_points >> points_per_transcript >> transcript_num >> transcript_path))
+    {
+        return id + " error Invalid arguments.";
+    }
+    iss >> transcript0_path >> transcript_previous_path;
+    if (transcript0_path.empty())
+    {
+        transcript0_path = transcript_path;
+    }
+
+    try
+    {
+        streaming::Manifest manifest;
+        streaming::read_transcript_manifest(manifest, transcript_path);
+        validate_manifest(manifest, total_g1_points, total_g2_points, points_per_transcript, transcript_num);
+        verify_transcript(cache, manifest, transcript_path, transcript0_path, transcript_previous_path, window_points, small_exponents, prefix_points);
+        return id + " valid";
+    }
+    catch (std::exception const &err)
+    {
+        return id + " invalid " + err.what();
+    }
+}
+
+// Verifies transcripts on request, one command per line of stdin, like setup's process_commands. Up to num_jobs
+// commands run at once, sharing the thread pool, the boundary points of recently seen transcripts and the pairing
+// precomputation of fixed G2 points. Each response is written to stdout as its verification completes, and
+// everything else goes to stderr.
+int run_daemon(size_t num_jobs, size_t window_points, bool small_exponents, size_t prefix_points)
+{
     libff::alt_bn128_pp::init_public_params();
 
-    if (!streaming::is_file_exist(transcript_path))
+    std::ostream responses(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    VerifierCache cache;
+    std::deque<std::string> commands;
+    bool done = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::max(num_jobs, (size_t)1); ++i)
     {
-        std::cout << "Transcript not found: " << transcript_path << std::endl;
-        return 1;
+        workers.emplace_back([&] {
+            for (;;)
+            {
+                std::string line;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return done || !commands.empty(); });
+                    if (commands.empty())
+                    {
+                        return;
+                    }
+                    line = commands.front();
+                    commands.pop_front();
+                }
+
+                std::string response = process_command(cache, line, window_points, small_exponents, prefix_points);
+                std::lock_guard<std::mutex> lock(mutex);
+                responses << response << std::endl;
+            }
+        });
     }
-    if (!streaming::is_file_exist(transcript0_path))
+
+    std::cerr << "Awaiting commands from stdin..." << std::endl;
+    for (std::string line; std::getline(std::cin, line);)
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.push_back(line);
+        cv.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    cv.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    return 0;
+}
+
+// Verifies a transcript as it is written, to a file or to stdin.
+int verify_growing(int num_args, char **args, size_t window_points, bool small_exponents)
+{
+    size_t const total_g1_points = strtol(args[0], NULL, 0);
+    size_t const total_g2_points = strtol(args[1], NULL, 0);
+    size_t const points_per_transcript = strtol(args[2], NULL, 0);
+    size_t const transcript_num = strtol(args[3], NULL, 0);
+    std::string const transcript_path(args[4]);
+    std::string const transcript0_path(num_args == 5 ? args[4] : args[5]);
+    std::string const transcript_previous_path(num_args > 6 ? args[6] : "");
+
+    libff::alt_bn128_pp::init_public_params();
+
+    if (transcript0_path != transcript_path && !streaming::is_file_exist(transcript0_path))
     {
         std::cout << "Transcript 0 not found: " << transcript0_path << std::endl;
         return 1;
@@ -39,72 +152,333 @@ int main(int argc, char **argv)
 
     try
     {
+        VerifierCache cache;
         streaming::Manifest manifest;
-        std::vector<G1> g1_x;
-        std::vector<G2> g2_x;
-        std::vector<G1> g1_0_0;
-        std::vector<G2> g2_0_0;
-        std::vector<G1> g1_x_previous;
-        std::vector<G2> g2_y;
+        verify_growing_transcript(
+            cache,
+            manifest,
+            transcript_path,
+            transcript0_path,
+            transcript_previous_path,
+            [&](streaming::Manifest const &transcript_manifest) {
+                validate_manifest(transcript_manifest, total_g1_points, total_g2_points, points_per_transcript, transcript_num);
+            },
+            window_points,
+            small_exponents);
 
-        // Read first points from transcript 0.
-        streaming::read_transcript_g1_points(g1_0_0, transcript0_path, 0, 1);
-        streaming::read_transcript_g2_points(g2_0_0, transcript0_path, 0, 1);
+        std::cout << "Transcript valid." << std::endl;
+        return 0;
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
 
-        if (!g1_0_0.size() || !g2_0_0.size())
+// A seed given as hex.
+std::vector<unsigned char> parse_seed(std::string const &hex)
+{
+    if (hex.empty() || hex.size() % 2 || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+    {
+        throw std::runtime_error("Seed must be an even number of hex digits.");
+    }
+    std::vector<unsigned char> seed(hex.size() / 2);
+    for (size_t i = 0; i < seed.size(); ++i)
+    {
+        seed[i] = (unsigned char)std::stoul(hex.substr(2 * i, 2), nullptr, 16);
+    }
+    return seed;
+}
+
+// Accumulates a range of a transcript's points, and prints their partial keys for --combine.
+int verify_range(std::string const &seed_hex, char **args, size_t window_points, bool small_exponents)
+{
+    size_t const first_point = strtol(args[0], NULL, 0);
+    size_t const num_points = strtol(args[1], NULL, 0);
+    std::string const transcript_path(args[2]);
+
+    libff::alt_bn128_pp::init_public_params();
+
+    try
+    {
+        TranscriptPartial partial = verify_partial(transcript_path, parse_seed(seed_hex), first_point, num_points, window_points, small_exponents);
+        write_partial(std::cout, partial);
+        return 0;
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
+// Verifies a transcript from the partial keys of its ranges, one per line of stdin.
+int verify_partials(std::string const &seed_hex, int num_args, char **args, bool small_exponents)
+{
+    size_t const total_g1_points = strtol(args[0], NULL, 0);
+    size_t const total_g2_points = strtol(args[1], NULL, 0);
+    size_t const points_per_transcript = strtol(args[2], NULL, 0);
+    size_t const transcript_num = strtol(args[3], NULL, 0);
+    std::string const transcript_path(args[4]);
+    std::string const transcript0_path(num_args == 5 ? args[4] : args[5]);
+    std::string const transcript_previous_path(num_args > 6 ? args[6] : "");
+
+    libff::alt_bn128_pp::init_public_params();
+
+    try
+    {
+        std::vector<TranscriptPartial> partials;
+        for (std::string line; std::getline(std::cin, line);)
         {
-            throw std::runtime_error("Missing either G1 or G2 zero point.");
+            if (!line.empty())
+            {
+                partials.push_back(read_partial(line));
+            }
         }
 
+        streaming::Manifest manifest;
         streaming::read_transcript_manifest(manifest, transcript_path);
         validate_manifest(manifest, total_g1_points, total_g2_points, points_per_transcript, transcript_num);
+        verify_combine(manifest, transcript_path, transcript0_path, transcript_previous_path, parse_seed(seed_hex), partials, small_exponents);
+
+        std::cout << "Transcript valid." << std::endl;
+        return 0;
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
+// Verifies every transcript of a participant together.
+int verify_all(int num_args, char **args, size_t window_points, bool small_exponents)
+{
+    size_t const total_g1_points = strtol(args[0], NULL, 0);
+    size_t const total_g2_points = strtol(args[1], NULL, 0);
+    size_t const points_per_transcript = strtol(args[2], NULL, 0);
+    std::string const transcript_dir(args[3]);
+    std::string const previous_transcript0_path(num_args > 4 ? args[4] : "");
+
+    libff::alt_bn128_pp::init_public_params();
+
+    if (!previous_transcript0_path.empty() && !streaming::is_file_exist(previous_transcript0_path))
+    {
+        std::cout << "Previous transcript not found: " << previous_transcript0_path << std::endl;
+        return 1;
+    }
 
-        if (manifest.transcript_number == 0)
+    try
+    {
+        streaming::TranscriptSet set = streaming::find_transcripts(transcript_dir);
+        for (size_t i = 0; i < set.size(); ++i)
         {
-            // If we are transcript 0 we need to add the generator point to the beginning of the series.
-            // This allows validating a single point as there will be at least 2 in the series.
-            g1_x.push_back(G1::one());
-            g2_x.push_back(G2::one());
+            validate_manifest(set.manifests[i], total_g1_points, total_g2_points, points_per_transcript, i);
         }
 
-        if (transcript_previous_path.empty())
+        verify_transcripts(set, previous_transcript0_path, window_points, small_exponents);
+
+        std::cout << "Transcripts valid." << std::endl;
+        return 0;
+    }
+    catch (std::exception const &err)
+    {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // An optional --ledger <path> records results, and answers repeat verifications from them.
+    // --small-exponents weights the powering sequence checks with independent 128-bit random coefficients.
+    // --window <points> bounds how many points of each group are held in memory at once.
+    // --all verifies a directory holding every transcript of a participant, rather than one transcript.
+    // --daemon takes verification commands from stdin, running up to --jobs <num> at once.
+    // --follow verifies a transcript as it is written, tailing a growing file, or reading stdin given "-".
+    // --staged checks the derivation from the previous participant and the first points before the whole transcript.
+    // --partial <seed> accumulates a range of a transcript's points, and --combine <seed> verifies it from the
+    // ranges' partial keys.
+    std::string ledger_path;
+    std::string partial_seed;
+    std::string combine_seed;
+    bool all = false;
+    bool daemon = false;
+    bool follow = false;
+    size_t num_jobs = 1;
+    bool small_exponents = false;
+    size_t prefix_points = 0;
+    size_t window_points = DEFAULT_WINDOW_POINTS;
+    int first_arg = 1;
+    while (first_arg < argc)
+    {
+        std::string const option(argv[first_arg]);
+        if (option == "--ledger" && first_arg + 1 < argc)
         {
-            // First participant, first transcript. Discard our g2^y point.
-            if (manifest.transcript_number != 0)
-            {
-                throw std::runtime_error("Must provide a previous transcript if not transcript 0.");
-            }
-            streaming::read_transcript(g1_x, g2_x, manifest, transcript_path);
-            g2_x.pop_back();
+            ledger_path = argv[first_arg + 1];
+            first_arg += 2;
+        }
+        else if (option == "--partial" && first_arg + 1 < argc)
+        {
+            partial_seed = argv[first_arg + 1];
+            first_arg += 2;
+        }
+        else if (option == "--combine" && first_arg + 1 < argc)
+        {
+            combine_seed = argv[first_arg + 1];
+            first_arg += 2;
+        }
+        else if (option == "--window" && first_arg + 1 < argc)
+        {
+            window_points = strtol(argv[first_arg + 1], NULL, 0);
+            first_arg += 2;
+        }
+        else if (option == "--jobs" && first_arg + 1 < argc)
+        {
+            num_jobs = strtol(argv[first_arg + 1], NULL, 0);
+            first_arg += 2;
+        }
+        else if (option == "--daemon")
+        {
+            daemon = true;
+            ++first_arg;
+        }
+        else if (option == "--follow")
+        {
+            follow = true;
+            ++first_arg;
+        }
+        else if (option == "--all")
+        {
+            all = true;
+            ++first_arg;
+        }
+        else if (option == "--staged")
+        {
+            prefix_points = DEFAULT_PREFIX_POINTS;
+            ++first_arg;
+        }
+        else if (option == "--small-exponents")
+        {
+            small_exponents = true;
+            ++first_arg;
         }
         else
         {
-            streaming::Manifest previous_manifest;
-            streaming::read_transcript_manifest(previous_manifest, transcript_previous_path);
+            break;
+        }
+    }
+    char **args = argv + first_arg;
 
-            // If this transcript and previous transcript are 0, we are going to check this transcript was built
-            // on top of the previous participants using the g2^y and previous g1_x points.
-            if (manifest.transcript_number == 0 && previous_manifest.transcript_number == 0)
-            {
-                streaming::read_transcript_g1_points(g1_x_previous, transcript_previous_path, 0, 1);
-                streaming::read_transcript(g1_x, g2_x, manifest, transcript_path);
-                // Extract g2_y point from this transcript.
-                g2_y.push_back(g2_x.back());
-                g2_x.pop_back();
-            }
-            else
+    // The other modes each verify a whole transcript in one process.
+    const bool distributed = !partial_seed.empty() || !combine_seed.empty();
+    if (distributed && (daemon || all || follow || prefix_points || !ledger_path.empty() || (!partial_seed.empty() && !combine_seed.empty())))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!partial_seed.empty())
+    {
+        if (argc - first_arg != 3)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return verify_range(partial_seed, args, window_points, small_exponents);
+    }
+
+    if (!combine_seed.empty())
+    {
+        if (argc - first_arg < 5)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return verify_partials(combine_seed, argc - first_arg, args, small_exponents);
+    }
+
+    if (daemon)
+    {
+        if (argc != first_arg || all || follow || !ledger_path.empty())
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return run_daemon(num_jobs, window_points, small_exponents, prefix_points);
+    }
+
+    if (all)
+    {
+        if (argc - first_arg < 4 || follow || prefix_points || !ledger_path.empty())
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return verify_all(argc - first_arg, args, window_points, small_exponents);
+    }
+
+    if (follow)
+    {
+        if (argc - first_arg < 5 || prefix_points || !ledger_path.empty())
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return verify_growing(argc - first_arg, args, window_points, small_exponents);
+    }
+
+    if (argc - first_arg < 5)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    size_t const total_g1_points = strtol(args[0], NULL, 0);
+    size_t const total_g2_points = strtol(args[1], NULL, 0);
+    size_t const points_per_transcript = strtol(args[2], NULL, 0);
+    size_t const transcript_num = strtol(args[3], NULL, 0);
+    std::string const transcript_path(args[4]);
+    std::string const transcript0_path(argc - first_arg == 5 ? args[4] : args[5]);
+    std::string const transcript_previous_path(argc - first_arg > 6 ? args[6] : "");
+
+    libff::alt_bn128_pp::init_public_params();
+
+    if (!streaming::is_file_exist(transcript_path))
+    {
+        std::cout << "Transcript not found: " << transcript_path << std::endl;
+        return 1;
+    }
+    if (!streaming::is_file_exist(transcript0_path))
+    {
+        std::cout << "Transcript 0 not found: " << transcript0_path << std::endl;
+        return 1;
+    }
+    if (!transcript_previous_path.empty() && !streaming::is_file_exist(transcript_previous_path))
+    {
+        std::cout << "Previous transcript not found: " << transcript_previous_path << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        streaming::Manifest manifest;
+        streaming::read_transcript_manifest(manifest, transcript_path);
+        validate_manifest(manifest, total_g1_points, total_g2_points, points_per_transcript, transcript_num);
+
+        if (!ledger_path.empty())
+        {
+            streaming::TranscriptLedger ledger(ledger_path);
+            if (verify_recorded_transcript(ledger, manifest, transcript_path, transcript0_path, transcript_previous_path, window_points, small_exponents, prefix_points))
             {
-                // Read the last points from the previous transcript to validate the sequence.
-                // Second to last g2 point if the previous transcript is 0, due to g2^y being tacked on.
-                streaming::read_transcript_g1_points(g1_x, transcript_previous_path, -1, 1);
-                size_t from_g2_end = previous_manifest.transcript_number == 0 ? -2 : -1;
-                streaming::read_transcript_g2_points(g2_x, transcript_previous_path, from_g2_end, 1);
-                streaming::read_transcript(g1_x, g2_x, manifest, transcript_path);
+                std::cout << "Transcript valid (recorded in ledger)." << std::endl;
+                return 0;
             }
         }
-
-        std::cout << "Verifying..." << std::endl;
-        validate_transcript(g1_0_0[0], g2_0_0[0], g1_x, g2_x, g1_x_previous, g2_y);
+        else
+        {
+            verify_transcript(manifest, transcript_path, transcript0_path, transcript_previous_path, window_points, small_exponents, prefix_points);
+        }
 
         std::cout << "Transcript valid." << std::endl;
         return 0;
@@ -114,4 +488,4 @@ int main(int argc, char **argv)
         std::cerr << err.what() << std::endl;
         return 1;
     }
-}
\ No newline at end of file
+}
@@ -4,103 +4,237 @@
  **/
 
 #include "verifier.hpp"
-#include <thread>
+#include <aztec_common/pippenger.hpp>
+#include <aztec_common/point_checks.hpp>
+#include <aztec_common/streaming_g1.hpp>
+#include <aztec_common/streaming_g2.hpp>
+#include <aztec_common/thread_pool.hpp>
+#include <blake2.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <future>
+#include <limits>
+#include <memory>
+#include <sstream>
 
-template <typename GroupT>
-VerificationKey<GroupT> same_ratio_preprocess_thread(std::vector<GroupT> const &g_x, std::vector<Fq> const &scalars, size_t start_from, size_t num)
+namespace
 {
-    VerificationKey<GroupT> key;
 
-    key.lhs = libff::multi_exp<GroupT, Fq, libff::multi_exp_method_bos_coster>(
-        g_x.cbegin() + start_from,
-        g_x.cbegin() + start_from + num - 1,
-        scalars.cbegin() + start_from,
-        scalars.cbegin() + start_from + num - 1,
-        1);
+// Number of coefficients generated per task.
+constexpr size_t COEFFICIENTS_PER_TASK = 1 << 16;
 
-    key.rhs = libff::multi_exp<GroupT, Fq, libff::multi_exp_method_bos_coster>(
-        g_x.cbegin() + start_from + 1,
-        g_x.cbegin() + start_from + num,
-        scalars.cbegin() + start_from,
-        scalars.cbegin() + start_from + num - 1,
-        1);
+std::vector<unsigned char> random_seed()
+{
+    std::vector<unsigned char> seed(BLAKE2B_KEYBYTES);
+    std::ifstream urandom("/dev/urandom", std::ios::binary);
+    if (!urandom.read((char *)&seed[0], seed.size()))
+    {
+        throw std::runtime_error("Failed to read random seed.");
+    }
+    return seed;
+}
 
-    return key;
+// Independent, uniformly random 128-bit coefficients r_first, ..., r_(first + num - 1). Blake2b keyed with the seed
+// is used as a PRF over each coefficient's index, so they can be generated in parallel, and in any order.
+std::vector<libff::bigint<Fr::num_limbs>> random_coefficients(std::vector<unsigned char> const &seed, size_t first, size_t num)
+{
+    std::vector<libff::bigint<Fr::num_limbs>> coefficients(num);
+    parallel::parallel_for((num + COEFFICIENTS_PER_TASK - 1) / COEFFICIENTS_PER_TASK, [&](size_t task) {
+        const size_t end = std::min(num, (task + 1) * COEFFICIENTS_PER_TASK);
+        for (size_t i = task * COEFFICIENTS_PER_TASK; i < end; ++i)
+        {
+            uint64_t index = first + i;
+            uint64_t coefficient[2];
+            blake2b(coefficient, sizeof(coefficient), &index, sizeof(index), &seed[0], seed.size());
+            libff::bigint<Fr::num_limbs> &out = coefficients[i];
+            std::fill(out.data, out.data + Fr::num_limbs, 0);
+            out.data[0] = coefficient[0];
+            out.data[1] = coefficient[1];
+        }
+    });
+    return coefficients;
 }
 
-// We want to validate that a vector of points corresponds to the terms [x, x^2, ..., x^n]
-// of an indeterminate x and a random variable z
-// Update the verification key so that...
-// key.lhs = x.z + x^2.z^2 + ... + x^(n-1).z^(n-1)
-// key.rhs = x^2.z + ... + x^n.z^(n-1)
+// A challenge in Fr drawn from the seed, as two 128-bit halves from Blake2b keyed with it, so that every process
+// sharing the seed draws the same one.
+Fr seeded_challenge(std::vector<unsigned char> const &seed)
+{
+    if (seed.empty() || seed.size() > BLAKE2B_KEYBYTES)
+    {
+        throw std::runtime_error("Seed must hold between 1 and " + std::to_string(BLAKE2B_KEYBYTES) + " bytes.");
+    }
+    const char label[] = "challenge";
+    uint64_t digest[4];
+    blake2b(digest, sizeof(digest), label, sizeof(label), &seed[0], seed.size());
+    libff::bigint<Fr::num_limbs> high, low;
+    std::fill(high.data, high.data + Fr::num_limbs, 0);
+    std::fill(low.data, low.data + Fr::num_limbs, 0);
+    high.data[0] = digest[0];
+    high.data[1] = digest[1];
+    low.data[0] = digest[2];
+    low.data[1] = digest[3];
+    return Fr(high) * (Fr(2) ^ 128UL) + Fr(low);
+}
+
+} // namespace
+
 template <typename GroupT>
-VerificationKey<GroupT> same_ratio_preprocess(std::vector<GroupT> const &g_x)
+SameRatioAccumulator<GroupT>::SameRatioAccumulator(bool small_exponents)
+    : SameRatioAccumulator(random_seed(), small_exponents)
 {
-    Fq challenge = Fq::random_element();
-    if (challenge.is_zero() || challenge == Fq::one())
+}
+
+template <typename GroupT>
+SameRatioAccumulator<GroupT>::SameRatioAccumulator(std::vector<unsigned char> const &seed, bool small_exponents)
+    : small_exponents_(small_exponents)
+    , begin_(std::numeric_limits<size_t>::max())
+    , size_(0)
+    , first_(GroupT::zero())
+    , last_(GroupT::zero())
+    , sum_(GroupT::zero())
+    , seed_(seed)
+    , lhs_(GroupT::zero())
+    , rhs_(GroupT::zero())
+{
+    // The scalars live in Fr, the groups' scalar field, so that z.z^i = z^(i+1) holds for the group elements too.
+    challenge_ = seeded_challenge(seed_);
+    if (challenge_.is_zero() || challenge_ == Fr::one())
     {
         throw std::runtime_error("Challenge is 0 or 1.");
     }
+}
+
+template <typename GroupT>
+void SameRatioAccumulator<GroupT>::add(size_t index, GroupT const *points, size_t num)
+{
+    if (num == 0)
+    {
+        return;
+    }
 
-    std::vector<Fq> scalars(g_x.size());
-    scalars[0] = challenge;
-    for (size_t i = 1; i < scalars.size(); ++i)
+    GroupT sum = GroupT::zero();
+    GroupT lhs = GroupT::zero();
+    GroupT rhs = GroupT::zero();
+    if (small_exponents_)
     {
-        scalars[i] = scalars[i - 1] * challenge;
+        // Point i of the sequence is weighted by r_i in lhs_ and by r_(i-1) in rhs_, so the window needs the
+        // coefficient of the point before it too.
+        const size_t first = index ? index - 1 : 0;
+        auto coefficients = random_coefficients(seed_, first, index + num - first);
+        lhs = pippenger::multi_exp(points, &coefficients[index - first], num);
+        rhs = index ? pippenger::multi_exp(points, &coefficients[0], num)
+                    : pippenger::multi_exp(points + 1, &coefficients[0], num - 1);
+    }
+    else
+    {
+        std::vector<Fr> scalars(num);
+        scalars[0] = challenge_ ^ (unsigned long)index;
+        for (size_t i = 1; i < num; ++i)
+        {
+            scalars[i] = scalars[i - 1] * challenge_;
+        }
+        sum = pippenger::multi_exp(points, &scalars[0], num);
     }
 
-    size_t num_threads = std::thread::hardware_concurrency();
-    num_threads = num_threads ? num_threads : 4;
-    size_t thread_range = g_x.size() / num_threads;
-    size_t leftovers = g_x.size() - (thread_range * num_threads);
-    std::vector<std::thread> threads;
-    std::vector<std::future<VerificationKey<GroupT>>> results;
+    merge({index, index + num, points[0], points[num - 1], sum, lhs, rhs});
+}
 
-    if (thread_range < 2)
+template <typename GroupT>
+void SameRatioAccumulator<GroupT>::merge(PartialKey<GroupT> const &partial)
+{
+    if (partial.begin >= partial.end)
     {
-        return same_ratio_preprocess_thread(g_x, scalars, 0, g_x.size());
+        return;
     }
 
-    for (uint i = 0; i < num_threads; i++)
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (partial.begin < begin_)
     {
-        size_t start_from = (i * thread_range);
-        if (i == num_threads - 1)
-        {
-            thread_range += leftovers;
-        }
-        results.push_back(std::async(std::launch::async, same_ratio_preprocess_thread<GroupT>, std::ref(g_x), std::ref(scalars), start_from, thread_range));
+        begin_ = partial.begin;
+        first_ = partial.first;
     }
+    if (partial.end > size_)
+    {
+        last_ = partial.last;
+    }
+    size_ = std::max(size_, partial.end);
+    sum_ = sum_ + partial.sum;
+    lhs_ = lhs_ + partial.lhs;
+    rhs_ = rhs_ + partial.rhs;
+}
 
-    VerificationKey<GroupT> key(results[0].get());
-    for (uint i = 1; i < results.size(); i++)
+template <typename GroupT>
+PartialKey<GroupT> SameRatioAccumulator<GroupT>::partial() const
+{
+    if (size_ == 0)
+    {
+        return {0, 0, GroupT::zero(), GroupT::zero(), GroupT::zero(), GroupT::zero(), GroupT::zero()};
+    }
+    return {begin_, size_, first_, last_, sum_, lhs_, rhs_};
+}
+
+template <typename GroupT>
+VerificationKey<GroupT> SameRatioAccumulator<GroupT>::key() const
+{
+    VerificationKey<GroupT> key;
+    if (size_ && begin_ != 0)
+    {
+        throw VerificationFailure("Sequence is missing its first points.");
+    }
+    if (size_ < 2)
     {
-        auto r = results[i].get();
-        key.lhs = key.lhs + r.lhs;
-        key.rhs = key.rhs + r.rhs;
+        key.lhs = GroupT::zero();
+        key.rhs = GroupT::zero();
+        return key;
     }
+
+    if (small_exponents_)
+    {
+        // key.lhs = r_0.x + r_1.x^2 + ... + r_(n-2).x^(n-1)
+        // key.rhs = r_0.x^2 + ... + r_(n-2).x^n
+        // for independent random r_i. The coefficients no longer line up between the sums, so each needs its own
+        // multi-exponentiation, but soundness only needs 128-bit r_i, which halves the windows of each.
+        // lhs_ has the last point weighted too, which is taken back out.
+        key.lhs = lhs_ - random_coefficients(seed_, size_ - 1, 1)[0] * last_;
+        key.rhs = rhs_;
+        return key;
+    }
+
+    // Both sums come from the one multi-exponentiation sum = g_x[0] + z.g_x[1] + ... + z^(n-1).g_x[n-1]:
+    // key.rhs = sum - g_x[0]
+    // key.lhs = z.(sum - z^(n-1).g_x[n-1])
+    Fr last_power = challenge_ ^ (unsigned long)(size_ - 1);
+    key.rhs = sum_ - first_;
+    key.lhs = challenge_.as_bigint() * (sum_ - last_power.as_bigint() * last_);
     return key;
 }
 
+template class SameRatioAccumulator<G1>;
+template class SameRatioAccumulator<G2>;
+
+// We want to validate that a vector of points corresponds to the terms [x, x^2, ..., x^n]
+// of an indeterminate x and a random variable z
+// Update the verification key so that...
+// key.lhs = x.z + x^2.z^2 + ... + x^(n-1).z^(n-1)
+// key.rhs = x^2.z + ... + x^n.z^(n-1)
+template <typename GroupT>
+VerificationKey<GroupT> same_ratio_preprocess(std::vector<GroupT> const &g_x, bool small_exponents)
+{
+    SameRatioAccumulator<GroupT> accumulator(small_exponents);
+    accumulator.add(g_x.data(), g_x.size());
+    return accumulator.key();
+}
+
 // Validate that g1_key.lhs * g2_key.lhs == g1_key.rhs * g2_key.rhs
 bool same_ratio(VerificationKey<G1> const &g1_key, VerificationKey<G2> const &g2_key)
 {
-// turn off profiling printf statements when computing a pairing
-#ifndef ENABLE_LIBFF_PROFILING
-    libff::inhibit_profiling_info = true;
-    libff::inhibit_profiling_counters = true;
-#endif // ENABLE_LIBFF_PROFILING
-
-    G1_precomp g1_lhs = ppT::precompute_G1(-g1_key.lhs);
-    G1_precomp g1_rhs = ppT::precompute_G1(g1_key.rhs);
-
     // lhs * delta = rhs * one
-    G2_precomp g2_lhs = ppT::precompute_G2(g2_key.lhs);
-    G2_precomp g2_rhs = ppT::precompute_G2(g2_key.rhs);
-
-    Fqk miller_result = ppT::double_miller_loop(g1_lhs, g2_lhs, g1_rhs, g2_rhs);
-    GT result = ppT::final_exponentiation(miller_result);
-    return result == GT::one();
+    pairing::MultiPairing product;
+    product.add(-g1_key.lhs, g2_key.lhs);
+    product.add(g1_key.rhs, g2_key.rhs);
+    return product.is_one();
 }
 
 // We want to validate that a vector of points corresponds to the terms [x, x^2, ..., x^n] of an indeterminate x
@@ -111,26 +245,26 @@ bool same_ratio(VerificationKey<G1> const &g1_key, VerificationKey<G2> const &g2
 // Because every term is multiplied by an independant random variable, we can treat each term as distinct.
 // Once we have A and B, we can validate that A*x = B via a pairing check.
 // This validates that our original vector represents the powering sequence that we desire
-bool validate_polynomial_evaluation(std::vector<G1> const &evaluation, G2 const &comparator)
+bool validate_polynomial_evaluation(std::vector<G1> const &evaluation, G2 const &comparator, bool small_exponents)
 {
     VerificationKey<G2> delta;
 
     delta.lhs = comparator;
     delta.rhs = G2::one();
 
-    VerificationKey<G1> key = same_ratio_preprocess(evaluation);
+    VerificationKey<G1> key = same_ratio_preprocess(evaluation, small_exponents);
 
     return same_ratio(key, delta);
 }
 
-bool validate_polynomial_evaluation(std::vector<G2> const &evaluation, G1 const &comparator)
+bool validate_polynomial_evaluation(std::vector<G2> const &evaluation, G1 const &comparator, bool small_exponents)
 {
     VerificationKey<G1> delta;
 
     delta.lhs = comparator;
     delta.rhs = G1::one();
 
-    VerificationKey<G2> key = same_ratio_preprocess(evaluation);
+    VerificationKey<G2> key = same_ratio_preprocess(evaluation, small_exponents);
 
     return same_ratio(delta, key);
 }
@@ -156,47 +290,47 @@ bool validate_transcript(
     std::vector<G1> const &g1_x,
     std::vector<G2> const &g2_x,
     std::vector<G1> const &g1_x_previous,
-    std::vector<G2> const &g2_y)
+    std::vector<G2> const &g2_y,
+    bool small_exponents)
 {
     if (g1_x_previous.size() && g2_y.size())
     {
         std::cout << "Checking transcript was derived from previous participants..." << std::endl;
         if (!validate_transcript_derived_from_previous(g1_x_previous[0], g1_0, g2_y[0]))
         {
-            throw std::runtime_error("Transcript was not derived from previous participants.");
+            throw VerificationFailure("Transcript was not derived from previous participants.");
         }
     }
 
-    for (size_t i = 0; i < g1_x.size(); ++i)
+    if (!point_checks::on_curve(g1_x.data(), g1_x.size()))
     {
-        if (!g1_x[i].is_well_formed() || g1_x[i].is_zero())
-        {
-            throw std::runtime_error("G1 element not on curve.");
-        }
+        throw VerificationFailure("G1 element not on curve.");
     }
 
-    for (size_t i = 0; i < g2_x.size(); ++i)
+    if (!point_checks::on_curve(g2_x.data(), g2_x.size()))
     {
-        if (!g2_x[i].is_well_formed() || g2_x[i].is_zero())
-        {
-            throw std::runtime_error("G2 element not on curve.");
-        }
+        throw VerificationFailure("G2 element not on curve.");
+    }
+
+    if (!point_checks::in_subgroup(g2_x.data(), g2_x.size()))
+    {
+        throw VerificationFailure("G2 element not in subgroup.");
     }
 
     // Validate that the ratio between successive g1_x elements is defined by g2_x[0].
     std::cout << "Checking " << g1_x.size() << " G1 points..." << std::endl;
-    if (!validate_polynomial_evaluation(g1_x, g2_0))
+    if (!validate_polynomial_evaluation(g1_x, g2_0, small_exponents))
     {
-        throw std::runtime_error("G1 elements failed.");
+        throw VerificationFailure("G1 elements failed.");
     }
 
     // Validate that the ratio between successive g2_x elements is defined by g1_x[0].
     if (g2_x.size() > 1)
     {
         std::cout << "Checking " << g2_x.size() << " G2 points..." << std::endl;
-        if (!validate_polynomial_evaluation(g2_x, g1_0))
+        if (!validate_polynomial_evaluation(g2_x, g1_0, small_exponents))
         {
-            throw std::runtime_error("G2 elements failed.");
+            throw VerificationFailure("G2 elements failed.");
         }
     }
 
@@ -241,4 +375,1015 @@ bool validate_manifest(streaming::Manifest const &manifest, size_t total_g1_poin
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+namespace
+{
+
+// Number of points decoded per task.
+constexpr size_t POINTS_PER_DECODE = 4096;
+
+void read_points(G1 *points, char const *buffer, size_t num)
+{
+    streaming::read_g1_elements_from_buffer(points, buffer, num);
+}
+
+void read_points(G2 *points, char const *buffer, size_t num)
+{
+    streaming::read_g2_elements_from_buffer(points, buffer, num);
+}
+
+// Buffers one group's serialized points as they stream in, and once window_points have arrived decodes them in
+// parallel, checking each is on the curve and that together they are in the subgroup, and adds them to the
+// accumulator from index onwards. Points past num_points are ignored, and the window is finished as soon as the last
+// one arrives.
+template <typename GroupT>
+class PointWindow
+{
+  public:
+    static constexpr size_t POINT_BYTES = sizeof(decltype(GroupT::X)) * (streaming::USE_COMPRESSION ? 1 : 2);
+
+    PointWindow(SameRatioAccumulator<GroupT> &accumulator, size_t window_points, size_t num_points, size_t index)
+        : accumulator_(accumulator)
+        , window_points_(window_points)
+        , remaining_(num_points)
+        , index_(index)
+    {
+    }
+
+    void push(char const *data, size_t size)
+    {
+        size_t num = std::min(size / POINT_BYTES, remaining_);
+        remaining_ -= num;
+        while (num)
+        {
+            buffer_.reserve(window_points_ * POINT_BYTES);
+            const size_t take = std::min(num, window_points_ - buffer_.size() / POINT_BYTES);
+            buffer_.insert(buffer_.end(), data, data + take * POINT_BYTES);
+            data += take * POINT_BYTES;
+            num -= take;
+            if (buffer_.size() == window_points_ * POINT_BYTES)
+            {
+                flush();
+            }
+        }
+        if (remaining_ == 0)
+        {
+            finish();
+        }
+    }
+
+    // Accumulates any points still buffered, and releases the window.
+    void finish()
+    {
+        flush();
+        std::vector<char>().swap(buffer_);
+        std::vector<GroupT>().swap(points_);
+    }
+
+  private:
+    void flush()
+    {
+        const size_t num = buffer_.size() / POINT_BYTES;
+        if (num == 0)
+        {
+            return;
+        }
+        points_.resize(num);
+        parallel::parallel_for((num + POINTS_PER_DECODE - 1) / POINTS_PER_DECODE, [&](size_t piece) {
+            const size_t start = piece * POINTS_PER_DECODE;
+            read_points(&points_[start], &buffer_[start * POINT_BYTES], std::min(POINTS_PER_DECODE, num - start));
+        });
+        if (!point_checks::in_subgroup(&points_[0], num))
+        {
+            throw VerificationFailure("Points are not in the subgroup!");
+        }
+        accumulator_.add(index_, &points_[0], num);
+        index_ += num;
+        buffer_.clear();
+    }
+
+    SameRatioAccumulator<GroupT> &accumulator_;
+    size_t window_points_;
+    size_t remaining_;
+    size_t index_;
+    std::vector<char> buffer_;
+    std::vector<GroupT> points_;
+};
+
+// Keeps the first and last points of a region as it streams through.
+template <typename GroupT>
+class BoundaryCapture
+{
+  public:
+    static constexpr size_t POINT_BYTES = PointWindow<GroupT>::POINT_BYTES;
+
+    void push(char const *data, size_t size)
+    {
+        if (size < POINT_BYTES)
+        {
+            return;
+        }
+        if (first_.empty())
+        {
+            first_.assign(data, data + POINT_BYTES);
+        }
+        last_.assign(data + size - POINT_BYTES, data + size);
+    }
+
+    // Each is empty if no points arrived, and is checked to be on the curve and in the subgroup.
+    std::vector<GroupT> first() const { return decode(first_); }
+
+    std::vector<GroupT> last() const { return decode(last_); }
+
+  private:
+    static std::vector<GroupT> decode(std::vector<char> const &buffer)
+    {
+        std::vector<GroupT> points(buffer.size() / POINT_BYTES);
+        if (points.size())
+        {
+            read_points(&points[0], &buffer[0], 1);
+            if (!point_checks::in_subgroup(&points[0], 1))
+            {
+                throw VerificationFailure("Points are not in the subgroup!");
+            }
+        }
+        return points;
+    }
+
+    std::vector<char> first_;
+    std::vector<char> last_;
+};
+
+// A term e(p, q) of a pairing check. fixed marks G2 points that recur between verifications, whose line
+// coefficients are worth caching.
+struct PairingTerm
+{
+    G1 p;
+    G2 q;
+    bool fixed;
+};
+
+// A relation a verification checks, that a product of pairings is one, and the error reported if it isn't.
+struct PairingCheck
+{
+    std::vector<PairingTerm> terms;
+    std::string error;
+};
+
+// Checks every relation as one product of pairings, with each relation raised to a random weight so that one that
+// fails makes the product fail with overwhelming probability. Relations sharing a G2 point share its Miller loop,
+// and all of them take a single final exponentiation. Only if the product fails are the relations evaluated one by
+// one, to report which failed.
+void check_pairings(std::vector<PairingCheck> const &checks, pairing::G2PrecomputeCache &cache)
+{
+    auto add = [&](pairing::MultiPairing &product, PairingTerm const &term, Fr const &weight) {
+        if (term.fixed)
+        {
+            product.add(weight * term.p, term.q, cache);
+        }
+        else
+        {
+            product.add(weight * term.p, term.q);
+        }
+    };
+
+    pairing::MultiPairing product;
+    for (size_t i = 0; i < checks.size(); ++i)
+    {
+        Fr weight = i == 0 ? Fr::one() : Fr::random_element();
+        for (auto const &term : checks[i].terms)
+        {
+            add(product, term, weight);
+        }
+    }
+    if (product.is_one())
+    {
+        return;
+    }
+
+    for (auto const &check : checks)
+    {
+        pairing::MultiPairing relation;
+        for (auto const &term : check.terms)
+        {
+            add(relation, term, Fr::one());
+        }
+        if (!relation.is_one())
+        {
+            throw VerificationFailure(check.error);
+        }
+    }
+    throw VerificationFailure("Pairing checks failed.");
+}
+
+} // namespace
+
+namespace
+{
+
+// Number of transcripts a VerifierCache keeps the boundary points of, beyond which the oldest are dropped.
+constexpr size_t MAX_CACHED_BOUNDARIES = 64;
+
+} // namespace
+
+std::shared_ptr<const TranscriptBoundary> VerifierCache::boundary(std::string const &path)
+{
+    // A file is identified by its inode, size and modification time as well as its path, so one rewritten in place
+    // is read again.
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        throw std::runtime_error("Transcript not found: " + path);
+    }
+    std::string key = path + ":" + std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" +
+                      std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = boundaries_.find(key);
+        if (it != boundaries_.end())
+        {
+            return it->second;
+        }
+    }
+
+    auto boundary = std::make_shared<TranscriptBoundary>();
+    streaming::read_transcript_manifest(boundary->manifest, path);
+    streaming::read_transcript_g1_points(boundary->g1_first, path, 0, 1);
+    streaming::read_transcript_g1_points(boundary->g1_last, path, -1, 1);
+    streaming::read_transcript_g2_points(boundary->g2_first, path, 0, 1);
+    streaming::read_transcript_g2_points(boundary->g2_last, path, -1, 1);
+    if (boundary->manifest.num_g2_points >= 2)
+    {
+        streaming::read_transcript_g2_points(boundary->g2_before_last, path, -2, 1);
+    }
+
+    // Boundary points are used in pairings without streaming through a window, so are checked here.
+    for (auto const *points : {&boundary->g2_first, &boundary->g2_last, &boundary->g2_before_last})
+    {
+        if (!point_checks::in_subgroup(points->data(), points->size()))
+        {
+            throw VerificationFailure("G2 points are not in the subgroup!");
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (boundaries_.emplace(key, boundary).second)
+    {
+        boundary_order_.push_back(key);
+        if (boundary_order_.size() > MAX_CACHED_BOUNDARIES)
+        {
+            boundaries_.erase(boundary_order_.front());
+            boundary_order_.pop_front();
+        }
+    }
+    return boundary;
+}
+
+void verify_transcript(streaming::Manifest &manifest,
+                       std::string const &transcript_path,
+                       std::string const &transcript0_path,
+                       std::string const &transcript_previous_path,
+                       size_t window_points,
+                       bool small_exponents,
+                       size_t prefix_points)
+{
+    VerifierCache cache;
+    verify_transcript(cache, manifest, transcript_path, transcript0_path, transcript_previous_path, window_points, small_exponents, prefix_points);
+}
+
+namespace
+{
+
+// The points a transcript's sequences follow on from: the generators for transcript 0, and the last points of the
+// previous transcript otherwise.
+struct SequenceStart
+{
+    // The previous transcript's boundary, if one was given.
+    std::shared_ptr<const TranscriptBoundary> previous;
+    std::vector<G1> g1;
+    std::vector<G2> g2;
+    // Number of the transcript's own G2 points in its sequence, which leaves out transcript 0's g2^y point.
+    size_t num_g2_points = 0;
+};
+
+SequenceStart sequence_start(VerifierCache &cache, streaming::Manifest const &manifest, std::string const &transcript_previous_path)
+{
+    SequenceStart start;
+
+    // Transcript 0 ends with the g2^y point, which is not part of the sequence.
+    start.num_g2_points = manifest.num_g2_points;
+    if (manifest.transcript_number == 0)
+    {
+        if (start.num_g2_points == 0)
+        {
+            throw VerificationFailure("Transcript 0 is missing its g2^y point.");
+        }
+        --start.num_g2_points;
+    }
+
+    if (transcript_previous_path.empty())
+    {
+        // First participant, first transcript.
+        if (manifest.transcript_number != 0)
+        {
+            throw std::runtime_error("Must provide a previous transcript if not transcript 0.");
+        }
+    }
+    else
+    {
+        start.previous = cache.boundary(transcript_previous_path);
+
+        if (manifest.transcript_number == 0)
+        {
+            // If this transcript is 0 the previous transcript is the previous participant's transcript 0, and
+            // we check this transcript was built on top of it using the g2^y and previous g1_x points.
+            if (start.previous->manifest.transcript_number != 0)
+            {
+                throw std::runtime_error("Transcript 0 must be checked against a previous transcript 0.");
+            }
+            if (!start.previous->g1_first.size())
+            {
+                throw VerificationFailure("Missing points to check transcript was derived from previous participants.");
+            }
+        }
+    }
+
+    if (manifest.transcript_number == 0)
+    {
+        // If we are transcript 0 we need to add the generator point to the beginning of the series.
+        // This allows validating a single point as there will be at least 2 in the series.
+        start.g1.push_back(G1::one());
+        start.g2.push_back(G2::one());
+    }
+    else
+    {
+        // The last points from the previous transcript validate the sequence carries on from it.
+        // Second to last g2 point if the previous transcript is 0, due to g2^y being tacked on.
+        start.g1 = start.previous->g1_last;
+        start.g2 = start.previous->manifest.transcript_number == 0 ? start.previous->g2_before_last : start.previous->g2_last;
+    }
+    return start;
+}
+
+// The relations a transcript's accumulated sequences must satisfy, for g1_0_0 and g2_0_0 the first points of
+// transcript 0. g2_y is transcript 0's g2^y point, which is only needed to check it against a previous transcript 0.
+std::vector<PairingCheck> transcript_checks(SequenceStart const &start,
+                                            streaming::Manifest const &manifest,
+                                            G1 const &g1_0_0,
+                                            G2 const &g2_0_0,
+                                            std::vector<G2> const &g2_y,
+                                            SameRatioAccumulator<G1> const &g1_accumulator,
+                                            SameRatioAccumulator<G2> const &g2_accumulator)
+{
+    std::vector<PairingCheck> checks;
+    if (start.previous && manifest.transcript_number == 0)
+    {
+        if (!g2_y.size())
+        {
+            throw VerificationFailure("Transcript 0 is missing its g2^y point.");
+        }
+        // e(g1_previous, g2^y) = e(x.g1, g2)
+        checks.push_back({{{start.previous->g1_first[0], g2_y[0], true}, {-g1_0_0, G2::one(), true}},
+                          "Transcript was not derived from previous participants."});
+    }
+
+    // Validate that the ratio between successive g1_x elements is defined by g2_x[0].
+    std::cout << "Checking " << g1_accumulator.size() << " G1 points..." << std::endl;
+    VerificationKey<G1> g1_key = g1_accumulator.key();
+    checks.push_back({{{-g1_key.lhs, g2_0_0, true}, {g1_key.rhs, G2::one(), true}}, "G1 elements failed."});
+
+    // Validate that the ratio between successive g2_x elements is defined by g1_x[0].
+    if (g2_accumulator.size() > 1)
+    {
+        std::cout << "Checking " << g2_accumulator.size() << " G2 points..." << std::endl;
+        VerificationKey<G2> g2_key = g2_accumulator.key();
+        checks.push_back({{{-g1_0_0, g2_key.lhs, false}, {G1::one(), g2_key.rhs, false}}, "G2 elements failed."});
+    }
+    return checks;
+}
+
+// Streams the transcript being verified to the decoders, calling on_manifest with its manifest before any points.
+// Throws if the checksum fails.
+using TranscriptStream = std::function<void(streaming::ManifestCallback const &, streaming::ChunkDecoder const &, streaming::ChunkDecoder const &)>;
+
+void verify_stream(VerifierCache &cache,
+                   streaming::Manifest &manifest,
+                   std::string const &transcript_path,
+                   std::string const &transcript0_path,
+                   std::string const &transcript_previous_path,
+                   size_t window_points,
+                   bool small_exponents,
+                   TranscriptStream const &stream)
+{
+    if (window_points == 0)
+    {
+        throw std::runtime_error("Window must hold at least one point.");
+    }
+
+    // First points from transcript 0. If that is the transcript being verified, they are taken as it streams
+    // through, as it may not have been fully written yet.
+    const bool is_transcript0 = transcript0_path == transcript_path;
+    std::shared_ptr<const TranscriptBoundary> transcript0;
+    if (!is_transcript0)
+    {
+        transcript0 = cache.boundary(transcript0_path);
+        if (!transcript0->g1_first.size() || !transcript0->g2_first.size())
+        {
+            throw VerificationFailure("Missing either G1 or G2 zero point.");
+        }
+    }
+
+    SameRatioAccumulator<G1> g1_accumulator(small_exponents);
+    SameRatioAccumulator<G2> g2_accumulator(small_exponents);
+    std::unique_ptr<PointWindow<G1>> g1_window;
+    std::unique_ptr<PointWindow<G2>> g2_window;
+    BoundaryCapture<G1> g1_boundary;
+    BoundaryCapture<G2> g2_boundary;
+    SequenceStart start;
+
+    auto on_manifest = [&](streaming::Manifest const &transcript_manifest) {
+        manifest = transcript_manifest;
+
+        start = sequence_start(cache, manifest, transcript_previous_path);
+        g1_accumulator.add(start.g1.data(), start.g1.size());
+        g2_accumulator.add(start.g2.data(), start.g2.size());
+
+        g1_window.reset(new PointWindow<G1>(g1_accumulator, window_points, manifest.num_g1_points, g1_accumulator.size()));
+        g2_window.reset(new PointWindow<G2>(g2_accumulator, window_points, start.num_g2_points, g2_accumulator.size()));
+    };
+
+    // The checksum is only validated once the whole transcript has streamed through, so nothing is accepted
+    // before then.
+    std::cout << "Verifying..." << std::endl;
+    stream(
+        on_manifest,
+        [&](char const *data, size_t size) {
+            g1_boundary.push(data, size);
+            g1_window->push(data, size);
+        },
+        [&](char const *data, size_t size) {
+            g2_boundary.push(data, size);
+            g2_window->push(data, size);
+        });
+    g1_window->finish();
+    g2_window->finish();
+
+    std::vector<G1> g1_0_0 = is_transcript0 ? g1_boundary.first() : transcript0->g1_first;
+    std::vector<G2> g2_0_0 = is_transcript0 ? g2_boundary.first() : transcript0->g2_first;
+    if (!g1_0_0.size() || !g2_0_0.size())
+    {
+        throw VerificationFailure("Missing either G1 or G2 zero point.");
+    }
+
+    // Every relation is checked together. g2^y is only decoded if it is needed.
+    std::vector<G2> g2_y = start.previous && manifest.transcript_number == 0 ? g2_boundary.last() : std::vector<G2>();
+    std::vector<PairingCheck> checks = transcript_checks(start, manifest, g1_0_0[0], g2_0_0[0], g2_y, g1_accumulator, g2_accumulator);
+    check_pairings(checks, cache.g2_precomputes());
+}
+
+// Checks the parts of a transcript where gross errors show up, which takes a few pairings over the boundary points
+// and the first prefix_points points of each group, rather than the whole transcript: that transcript 0 was derived
+// from the previous participant's, and that the first points carry on the sequence from the previous transcript.
+void check_prefix(VerifierCache &cache,
+                  streaming::Manifest const &manifest,
+                  std::string const &transcript_path,
+                  std::string const &transcript0_path,
+                  std::string const &transcript_previous_path,
+                  size_t prefix_points)
+{
+    auto current = cache.boundary(transcript_path);
+    auto transcript0 = transcript0_path == transcript_path ? current : cache.boundary(transcript0_path);
+    if (!transcript0->g1_first.size() || !transcript0->g2_first.size())
+    {
+        throw VerificationFailure("Missing either G1 or G2 zero point.");
+    }
+    G1 const &g1_0_0 = transcript0->g1_first[0];
+    G2 const &g2_0_0 = transcript0->g2_first[0];
+
+    // The prefix follows on from the generator for transcript 0, and from the previous transcript's last points
+    // otherwise.
+    SequenceStart start = sequence_start(cache, manifest, transcript_previous_path);
+    std::vector<G1> g1_x = start.g1;
+    std::vector<G2> g2_x = start.g2;
+    streaming::read_transcript_g1_points(g1_x, transcript_path, 0, std::min(prefix_points, (size_t)manifest.num_g1_points));
+    streaming::read_transcript_g2_points(g2_x, transcript_path, 0, std::min(prefix_points, start.num_g2_points));
+    if (!point_checks::on_curve(g1_x.data(), g1_x.size()))
+    {
+        throw VerificationFailure("G1 element not on curve.");
+    }
+    if (!point_checks::on_curve(g2_x.data(), g2_x.size()))
+    {
+        throw VerificationFailure("G2 element not on curve.");
+    }
+    if (!point_checks::in_subgroup(g2_x.data(), g2_x.size()))
+    {
+        throw VerificationFailure("G2 element not in subgroup.");
+    }
+
+    SameRatioAccumulator<G1> g1_accumulator;
+    SameRatioAccumulator<G2> g2_accumulator;
+    g1_accumulator.add(g1_x.data(), g1_x.size());
+    g2_accumulator.add(g2_x.data(), g2_x.size());
+    std::vector<PairingCheck> checks = transcript_checks(start, manifest, g1_0_0, g2_0_0, current->g2_last, g1_accumulator, g2_accumulator);
+    check_pairings(checks, cache.g2_precomputes());
+}
+
+} // namespace
+
+void verify_transcript(VerifierCache &cache,
+                       streaming::Manifest &manifest,
+                       std::string const &transcript_path,
+                       std::string const &transcript0_path,
+                       std::string const &transcript_previous_path,
+                       size_t window_points,
+                       bool small_exponents,
+                       size_t prefix_points)
+{
+    if (prefix_points)
+    {
+        std::cout << "Checking the first " << prefix_points << " points..." << std::endl;
+        check_prefix(cache, manifest, transcript_path, transcript0_path, transcript_previous_path, prefix_points);
+        std::cout << "Early checks passed." << std::endl;
+    }
+
+    verify_stream(cache, manifest, transcript_path, transcript0_path, transcript_previous_path, window_points, small_exponents,
+                  [&](streaming::ManifestCallback const &on_manifest, streaming::ChunkDecoder const &on_g1, streaming::ChunkDecoder const &on_g2) {
+                      on_manifest(manifest);
+                      streaming::stream_transcript(transcript_path, manifest, on_g1, on_g2);
+                  });
+}
+
+bool verify_recorded_transcript(streaming::TranscriptLedger &ledger,
+                                streaming::Manifest &manifest,
+                                std::string const &transcript_path,
+                                std::string const &transcript0_path,
+                                std::string const &transcript_previous_path,
+                                size_t window_points,
+                                bool small_exponents,
+                                size_t prefix_points)
+{
+    // A verification depends on every transcript involved, so all of them are identified by checksum.
+    auto transcript0_checksum = std::async(std::launch::async, streaming::read_checksum, transcript0_path);
+    auto previous_checksum = std::async(std::launch::async, [&] {
+        return transcript_previous_path.empty() ? std::vector<char>() : streaming::read_checksum(transcript_previous_path);
+    });
+    streaming::LedgerEntry entry;
+    entry.checksum = streaming::read_checksum(transcript_path);
+    entry.manifest = manifest;
+    entry.transcript0_checksum = transcript0_checksum.get();
+    entry.previous_checksum = previous_checksum.get();
+
+    auto recorded = ledger.find(entry.checksum, entry.transcript0_checksum, entry.previous_checksum);
+    if (recorded)
+    {
+        if (!recorded->valid)
+        {
+            throw VerificationFailure("Transcript recorded as invalid in ledger.");
+        }
+        return true;
+    }
+
+    try
+    {
+        verify_transcript(manifest, transcript_path, transcript0_path, transcript_previous_path, window_points, small_exponents, prefix_points);
+    }
+    catch (VerificationFailure const &)
+    {
+        entry.valid = false;
+        ledger.append(entry);
+        throw;
+    }
+
+    entry.valid = true;
+    ledger.append(entry);
+    return false;
+}
+
+void verify_growing_transcript(VerifierCache &cache,
+                               streaming::Manifest &manifest,
+                               std::string const &transcript_path,
+                               std::string const &transcript0_path,
+                               std::string const &transcript_previous_path,
+                               streaming::ManifestCallback const &check_manifest,
+                               size_t window_points,
+                               bool small_exponents,
+                               size_t timeout_seconds)
+{
+    verify_stream(cache, manifest, transcript_path, transcript0_path, transcript_previous_path, window_points, small_exponents,
+                  [&](streaming::ManifestCallback const &on_manifest, streaming::ChunkDecoder const &on_g1, streaming::ChunkDecoder const &on_g2) {
+                      streaming::follow_transcript(
+                          transcript_path,
+                          manifest,
+                          [&](streaming::Manifest const &transcript_manifest) {
+                              check_manifest(transcript_manifest);
+                              on_manifest(transcript_manifest);
+                          },
+                          on_g1,
+                          on_g2,
+                          timeout_seconds);
+                  });
+}
+
+void verify_transcripts(streaming::TranscriptSet const &set,
+                        std::string const &previous_transcript0_path,
+                        size_t window_points,
+                        bool small_exponents)
+{
+    verify_chain({set}, previous_transcript0_path, window_points, small_exponents);
+}
+
+void verify_chain(std::vector<streaming::TranscriptSet> const &sets,
+                  std::string const &previous_transcript0_path,
+                  size_t window_points,
+                  bool small_exponents)
+{
+    if (window_points == 0)
+    {
+        throw std::runtime_error("Window must hold at least one point.");
+    }
+    if (sets.empty())
+    {
+        throw std::runtime_error("No participants to verify.");
+    }
+
+    // Errors name the participant they come from, when there is more than one.
+    auto participant_error = [&](size_t p, std::string const &error) {
+        return sets.size() > 1 ? "Participant " + std::to_string(p) + ": " + error : error;
+    };
+
+    // Every participant's transcripts are joined into one set, so that they stream a few at a time across
+    // participants rather than one participant at a time.
+    streaming::TranscriptSet chain;
+    chain.g1_offsets.push_back(0);
+    chain.g2_offsets.push_back(0);
+    std::vector<size_t> participant_of;
+    for (size_t p = 0; p < sets.size(); ++p)
+    {
+        streaming::TranscriptSet const &set = sets[p];
+        if (set.manifests[0].total_g1_points != sets[0].manifests[0].total_g1_points ||
+            set.manifests[0].total_g2_points != sets[0].manifests[0].total_g2_points)
+        {
+            throw std::runtime_error(participant_error(p, "Total points disagree with the first participant."));
+        }
+        for (size_t i = 0; i < set.size(); ++i)
+        {
+            chain.paths.push_back(set.paths[i]);
+            chain.manifests.push_back(set.manifests[i]);
+            chain.g1_offsets.push_back(chain.g1_offsets.back() + set.manifests[i].num_g1_points);
+            chain.g2_offsets.push_back(chain.g2_offsets.back() + set.manifests[i].num_g2_points);
+            participant_of.push_back(p);
+        }
+    }
+
+    // The first points of each participant's transcript 0 define the ratio of both their sequences, and its g2^y
+    // point links it to the participant before.
+    std::vector<G1> g1_0_0(sets.size());
+    std::vector<G2> g2_0_0(sets.size());
+    std::vector<G2> g2_y(sets.size());
+    parallel::parallel_for(sets.size(), [&](size_t p) {
+        std::vector<G1> g1_x;
+        std::vector<G2> g2_x;
+        streaming::read_transcript_g1_points(g1_x, sets[p].paths[0], 0, 1);
+        streaming::read_transcript_g2_points(g2_x, sets[p].paths[0], 0, 1);
+        streaming::read_transcript_g2_points(g2_x, sets[p].paths[0], -1, 1);
+        if (!g1_x.size() || g2_x.size() < 2 || sets[p].manifests[0].num_g2_points < 2)
+        {
+            throw VerificationFailure(participant_error(p, "Missing either G1 or G2 zero point, or the g2^y point."));
+        }
+        if (!point_checks::in_subgroup(g2_x[1]))
+        {
+            throw VerificationFailure(participant_error(p, "G2 points are not in the subgroup!"));
+        }
+        g1_0_0[p] = g1_x[0];
+        g2_0_0[p] = g2_x[0];
+        g2_y[p] = g2_x[1];
+    });
+
+    std::vector<G1> g1_x_previous;
+    if (!previous_transcript0_path.empty())
+    {
+        streaming::read_transcript_g1_points(g1_x_previous, previous_transcript0_path, 0, 1);
+        if (!g1_x_previous.size())
+        {
+            throw std::runtime_error("Missing G1 zero point in previous transcript.");
+        }
+    }
+
+    // Every transcript's points join one sequence per group for each participant, following on from the generator,
+    // so the same-ratio check of the whole sequence also checks each transcript continues on from the one before.
+    // Transcript 0's g2^y point is left out of the G2 sequence.
+    std::vector<std::unique_ptr<SameRatioAccumulator<G1>>> g1_accumulators;
+    std::vector<std::unique_ptr<SameRatioAccumulator<G2>>> g2_accumulators;
+    G1 g1_generator = G1::one();
+    G2 g2_generator = G2::one();
+    for (size_t p = 0; p < sets.size(); ++p)
+    {
+        g1_accumulators.emplace_back(new SameRatioAccumulator<G1>(small_exponents));
+        g2_accumulators.emplace_back(new SameRatioAccumulator<G2>(small_exponents));
+        g1_accumulators.back()->add(0, &g1_generator, 1);
+        g2_accumulators.back()->add(0, &g2_generator, 1);
+    }
+
+    std::vector<std::unique_ptr<PointWindow<G1>>> g1_windows;
+    std::vector<std::unique_ptr<PointWindow<G2>>> g2_windows;
+    for (size_t p = 0; p < sets.size(); ++p)
+    {
+        streaming::TranscriptSet const &set = sets[p];
+        for (size_t i = 0; i < set.size(); ++i)
+        {
+            const size_t num_g2_points = set.manifests[i].num_g2_points - (i == 0 ? 1 : 0);
+            const size_t g2_index = i == 0 ? 1 : set.g2_offsets[i];
+            g1_windows.emplace_back(new PointWindow<G1>(*g1_accumulators[p], window_points, set.manifests[i].num_g1_points, 1 + set.g1_offsets[i]));
+            g2_windows.emplace_back(new PointWindow<G2>(*g2_accumulators[p], window_points, num_g2_points, g2_index));
+        }
+    }
+
+    // Transcripts are streamed a few at a time on the shared pool, which their decoding and multi-exponentiations
+    // run on too. Every checksum is validated before anything is accepted.
+    std::cout << "Verifying " << chain.size() << " transcripts..." << std::endl;
+    streaming::stream_transcripts(
+        chain,
+        0,
+        chain.size(),
+        [&](size_t transcript, size_t, char const *data, size_t size) { g1_windows[transcript]->push(data, size); },
+        [&](size_t transcript, size_t, char const *data, size_t size) { g2_windows[transcript]->push(data, size); });
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        g1_windows[i]->finish();
+        g2_windows[i]->finish();
+    }
+
+    // For each participant:
+    // G1 sequence:   e(lhs_1, x.g2) = e(rhs_1, g2)
+    // G2 sequence:   e(x.g1, lhs_2) = e(g1, rhs_2)
+    // Derived from the previous participant's transcript 0: e(g1_previous, g2^y) = e(x.g1, g2)
+    std::vector<PairingCheck> checks;
+    size_t num_g1_points = 0;
+    size_t num_g2_points = 0;
+    for (size_t p = 0; p < sets.size(); ++p)
+    {
+        VerificationKey<G1> g1_key = g1_accumulators[p]->key();
+        VerificationKey<G2> g2_key = g2_accumulators[p]->key();
+        num_g1_points += g1_accumulators[p]->size();
+        num_g2_points += g2_accumulators[p]->size();
+        checks.push_back({{{-g1_key.lhs, g2_0_0[p], false}, {g1_key.rhs, G2::one(), true}}, participant_error(p, "G1 elements failed.")});
+        checks.push_back({{{g1_0_0[p], g2_key.lhs, false}, {-G1::one(), g2_key.rhs, false}}, participant_error(p, "G2 elements failed.")});
+
+        G1 const *g1_previous = p ? &g1_0_0[p - 1] : g1_x_previous.size() ? &g1_x_previous[0] : nullptr;
+        if (g1_previous)
+        {
+            checks.push_back({{{*g1_previous, g2_y[p], false}, {-g1_0_0[p], G2::one(), true}},
+                              participant_error(p, "Transcript was not derived from previous participants.")});
+        }
+    }
+
+    // Every check of every participant ends in a single product of pairings.
+    std::cout << "Checking " << num_g1_points << " G1 points and " << num_g2_points << " G2 points..." << std::endl;
+    pairing::G2PrecomputeCache cache;
+    check_pairings(checks, cache);
+}
+
+namespace
+{
+
+void write_points(G1 const *points, size_t num, char *buffer)
+{
+    streaming::write_g1_elements_to_buffer(points, num, buffer);
+}
+
+void write_points(G2 const *points, size_t num, char *buffer)
+{
+    streaming::write_g2_elements_to_buffer(points, num, buffer);
+}
+
+// A point as the hex of its transcript encoding, or "0" for the point at infinity, which has none.
+template <typename GroupT>
+std::string point_to_hex(GroupT point)
+{
+    if (point.is_zero())
+    {
+        return "0";
+    }
+    point.to_affine_coordinates();
+    std::vector<char> buffer(PointWindow<GroupT>::POINT_BYTES);
+    write_points(&point, 1, &buffer[0]);
+    std::string hex;
+    for (unsigned char byte : buffer)
+    {
+        char digits[3];
+        snprintf(digits, sizeof(digits), "%02x", byte);
+        hex += digits;
+    }
+    return hex;
+}
+
+template <typename GroupT>
+GroupT point_from_hex(std::string const &hex)
+{
+    if (hex == "0")
+    {
+        return GroupT::zero();
+    }
+    std::vector<char> buffer(PointWindow<GroupT>::POINT_BYTES);
+    if (hex.size() != 2 * buffer.size() || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+    {
+        throw std::runtime_error("Malformed point in partial key.");
+    }
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+        buffer[i] = (char)std::stoul(hex.substr(2 * i, 2), nullptr, 16);
+    }
+    GroupT point;
+    read_points(&point, &buffer[0], 1);
+    return point;
+}
+
+template <typename GroupT>
+void write_partial_key(std::ostream &os, PartialKey<GroupT> const &key)
+{
+    os << key.begin << " " << key.end;
+    for (auto const *point : {&key.first, &key.last, &key.sum, &key.lhs, &key.rhs})
+    {
+        os << " " << point_to_hex(*point);
+    }
+}
+
+template <typename GroupT>
+PartialKey<GroupT> read_partial_key(std::istream &is)
+{
+    PartialKey<GroupT> key;
+    std::string first, last, sum, lhs, rhs;
+    if (!(is >> key.begin >> key.end >> first >> last >> sum >> lhs >> rhs))
+    {
+        throw std::runtime_error("Malformed partial key.");
+    }
+    key.first = point_from_hex<GroupT>(first);
+    key.last = point_from_hex<GroupT>(last);
+    key.sum = point_from_hex<GroupT>(sum);
+    key.lhs = point_from_hex<GroupT>(lhs);
+    key.rhs = point_from_hex<GroupT>(rhs);
+    return key;
+}
+
+void read_transcript_points(std::vector<G1> &points, std::string const &path, size_t offset, size_t num)
+{
+    streaming::read_transcript_g1_points(points, path, (int)offset, num);
+}
+
+void read_transcript_points(std::vector<G2> &points, std::string const &path, size_t offset, size_t num)
+{
+    streaming::read_transcript_g2_points(points, path, (int)offset, num);
+}
+
+// Accumulates points first, ..., first + num - 1 of one group of a transcript, which sit at index first + offset of
+// its sequence, window_points at a time.
+template <typename GroupT>
+void accumulate_range(SameRatioAccumulator<GroupT> &accumulator,
+                      std::string const &transcript_path,
+                      size_t first,
+                      size_t num,
+                      size_t offset,
+                      size_t window_points)
+{
+    std::vector<GroupT> points;
+    for (size_t start = first; start < first + num; start += window_points)
+    {
+        points.clear();
+        const size_t count = std::min(window_points, first + num - start);
+        read_transcript_points(points, transcript_path, start, count);
+        if (points.size() != count)
+        {
+            throw std::runtime_error("Transcript is missing points.");
+        }
+        if (!point_checks::in_subgroup(&points[0], count))
+        {
+            throw VerificationFailure("Points are not in the subgroup!");
+        }
+        accumulator.add(start + offset, &points[0], count);
+    }
+}
+
+// Merges the partial keys of one group, which must cover points offset, ..., offset + num_points - 1 of the
+// sequence exactly once.
+template <typename GroupT>
+void merge_partial_keys(SameRatioAccumulator<GroupT> &accumulator, std::vector<PartialKey<GroupT>> keys, size_t offset, size_t num_points, std::string const &group)
+{
+    std::sort(keys.begin(), keys.end(), [](PartialKey<GroupT> const &a, PartialKey<GroupT> const &b) { return a.begin < b.begin; });
+    size_t next = offset;
+    for (auto const &key : keys)
+    {
+        if (key.begin == key.end)
+        {
+            continue;
+        }
+        if (key.begin != next || key.end < key.begin)
+        {
+            throw std::runtime_error(group + " partial keys do not cover the transcript's points exactly once.");
+        }
+        accumulator.merge(key);
+        next = key.end;
+    }
+    if (next != offset + num_points)
+    {
+        throw std::runtime_error(group + " partial keys do not cover the transcript's points exactly once.");
+    }
+}
+
+} // namespace
+
+TranscriptPartial verify_partial(std::string const &transcript_path,
+                                 std::vector<unsigned char> const &seed,
+                                 size_t first_point,
+                                 size_t num_points,
+                                 size_t window_points,
+                                 bool small_exponents)
+{
+    if (window_points == 0)
+    {
+        throw std::runtime_error("Window must hold at least one point.");
+    }
+
+    // Each of the transcript's sequences starts with one point from elsewhere, so its points sit one on.
+    streaming::Manifest manifest;
+    streaming::read_transcript_manifest(manifest, transcript_path);
+    const size_t num_g2_points = manifest.num_g2_points - (manifest.transcript_number == 0 && manifest.num_g2_points ? 1 : 0);
+    const size_t g1_end = std::min(first_point + num_points, (size_t)manifest.num_g1_points);
+    const size_t g2_end = std::min(first_point + num_points, num_g2_points);
+
+    SameRatioAccumulator<G1> g1_accumulator(seed, small_exponents);
+    SameRatioAccumulator<G2> g2_accumulator(seed, small_exponents);
+    if (first_point < g1_end)
+    {
+        accumulate_range(g1_accumulator, transcript_path, first_point, g1_end - first_point, 1, window_points);
+    }
+    if (first_point < g2_end)
+    {
+        accumulate_range(g2_accumulator, transcript_path, first_point, g2_end - first_point, 1, window_points);
+    }
+    return {g1_accumulator.partial(), g2_accumulator.partial()};
+}
+
+void verify_combine(streaming::Manifest &manifest,
+                    std::string const &transcript_path,
+                    std::string const &transcript0_path,
+                    std::string const &transcript_previous_path,
+                    std::vector<unsigned char> const &seed,
+                    std::vector<TranscriptPartial> const &partials,
+                    bool small_exponents)
+{
+    // The points were never read here, so the transcript is hashed to check they are the ones that were sent.
+    auto skip = [](char const *, size_t) {};
+    streaming::stream_transcript(transcript_path, manifest, skip, skip);
+
+    VerifierCache cache;
+    auto current = cache.boundary(transcript_path);
+    auto transcript0 = cache.boundary(transcript0_path);
+    if (!transcript0->g1_first.size() || !transcript0->g2_first.size())
+    {
+        throw VerificationFailure("Missing either G1 or G2 zero point.");
+    }
+
+    SequenceStart start = sequence_start(cache, manifest, transcript_previous_path);
+    SameRatioAccumulator<G1> g1_accumulator(seed, small_exponents);
+    SameRatioAccumulator<G2> g2_accumulator(seed, small_exponents);
+    g1_accumulator.add(start.g1.data(), start.g1.size());
+    g2_accumulator.add(start.g2.data(), start.g2.size());
+
+    std::vector<PartialKey<G1>> g1_keys;
+    std::vector<PartialKey<G2>> g2_keys;
+    for (auto const &partial : partials)
+    {
+        g1_keys.push_back(partial.g1);
+        g2_keys.push_back(partial.g2);
+    }
+    merge_partial_keys(g1_accumulator, g1_keys, start.g1.size(), manifest.num_g1_points, "G1");
+    merge_partial_keys(g2_accumulator, g2_keys, start.g2.size(), start.num_g2_points, "G2");
+
+    std::vector<PairingCheck> checks = transcript_checks(
+        start, manifest, transcript0->g1_first[0], transcript0->g2_first[0], current->g2_last, g1_accumulator, g2_accumulator);
+    check_pairings(checks, cache.g2_precomputes());
+}
+
+void write_partial(std::ostream &os, TranscriptPartial const &partial)
+{
+    os << "partial ";
+    write_partial_key(os, partial.g1);
+    os << " ";
+    write_partial_key(os, partial.g2);
+    os << std::endl;
+}
+
+TranscriptPartial read_partial(std::string const &line)
+{
+    std::istringstream is(line);
+    std::string tag;
+    if (!(is >> tag) || tag != "partial")
+    {
+        throw std::runtime_error("Not a partial key: " + line);
+    }
+    TranscriptPartial partial;
+    partial.g1 = read_partial_key<G1>(is);
+    partial.g2 = read_partial_key<G2>(is);
+    return partial;
+}
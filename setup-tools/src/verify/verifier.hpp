@@ -4,7 +4,23 @@
  **/
 #pragma once
 
+#include <aztec_common/multi_pairing.hpp>
 #include <aztec_common/streaming_transcript.hpp>
+#include <aztec_common/transcript_ledger.hpp>
+#include <aztec_common/transcript_set.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+// Thrown when a transcript is found to be invalid, as opposed to an error that stopped it being checked at all, such
+// as failing to read it.
+class VerificationFailure : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
 
 template <typename GroupT>
 struct VerificationKey
@@ -15,12 +31,83 @@ struct VerificationKey
 
 bool same_ratio(VerificationKey<G1> const &g1_key, VerificationKey<G2> const &g2_key);
 
+// What one range of a sequence contributes to a SameRatioAccumulator, so that ranges can be accumulated by separate
+// processes, or hosts, and merged.
+template <typename GroupT>
+struct PartialKey
+{
+    // The range covers the points at begin, ..., end - 1 of the sequence, and first and last are the points at its
+    // ends.
+    size_t begin;
+    size_t end;
+    GroupT first;
+    GroupT last;
+    GroupT sum;
+    GroupT lhs;
+    GroupT rhs;
+};
+
+// Accumulates the verification key of same_ratio_preprocess over a sequence of points that arrives in windows, so
+// that no more than one window of the sequence needs to be in memory at once.
+template <typename GroupT>
+class SameRatioAccumulator
+{
+  public:
+    explicit SameRatioAccumulator(bool small_exponents = false);
+
+    // Draws the challenge, or coefficients, from seed rather than at random, so that accumulators sharing a seed
+    // weight the sequence the same way, and can merge their partial keys. The seed must not be known to whoever
+    // produced the points.
+    SameRatioAccumulator(std::vector<unsigned char> const &seed, bool small_exponents);
+
+    // Adds the num points at index, ..., index + num - 1 of the sequence. Windows can arrive in any order, and from
+    // several threads at once, but together must cover the sequence exactly once.
+    void add(size_t index, GroupT const *points, size_t num);
+
+    // Appends the next num points of the sequence.
+    void add(GroupT const *points, size_t num) { add(size_, points, num); }
+
+    size_t size() const { return size_; }
+
+    // Throws unless the points added so far cover the start of the sequence.
+    VerificationKey<GroupT> key() const;
+
+    // The contribution of the points added so far, which must be one contiguous range.
+    PartialKey<GroupT> partial() const;
+
+    // Adds a partial key from an accumulator sharing this one's seed, as if its points had been added.
+    void merge(PartialKey<GroupT> const &partial);
+
+  private:
+    SameRatioAccumulator(const SameRatioAccumulator &);
+    SameRatioAccumulator &operator=(const SameRatioAccumulator &);
+
+    bool small_exponents_;
+    std::mutex mutex_;
+    size_t begin_;
+    size_t size_;
+    GroupT first_;
+    GroupT last_;
+
+    // Weighted by powers of a challenge: sum_ = g_x[0] + z.g_x[1] + ...
+    Fr challenge_;
+    GroupT sum_;
+
+    // Weighted by independent coefficients, each drawn from seed_ by its index.
+    std::vector<unsigned char> seed_;
+    GroupT lhs_;
+    GroupT rhs_;
+};
+
+// By default the sums are weighted by successive powers of one random challenge, which lets both come from a single
+// multi-exponentiation. small_exponents weights them by independent random 128-bit coefficients instead, which takes
+// two multi-exponentiations over scalars of half the length.
 template <typename GroupT>
-VerificationKey<GroupT> same_ratio_preprocess(std::vector<GroupT> const &g_x);
+VerificationKey<GroupT> same_ratio_preprocess(std::vector<GroupT> const &g_x, bool small_exponents = false);
 
-bool validate_polynomial_evaluation(std::vector<G1> const &evaluation, G2 const &comparator);
+bool validate_polynomial_evaluation(std::vector<G1> const &evaluation, G2 const &comparator, bool small_exponents = false);
 
-bool validate_polynomial_evaluation(std::vector<G2> const &evaluation, G1 const &comparator);
+bool validate_polynomial_evaluation(std::vector<G2> const &evaluation, G1 const &comparator, bool small_exponents = false);
 
 bool validate_transcript(
     G1 &g1_0,
@@ -28,6 +115,145 @@ bool validate_transcript(
     std::vector<G1> const &g1_x,
     std::vector<G2> const &g2_x,
     std::vector<G1> const &g1_x_previous,
-    std::vector<G2> const &g2_y);
+    std::vector<G2> const &g2_y,
+    bool small_exponents = false);
+
+// Default number of points of each group decoded and held in memory at once by verify_transcript.
+constexpr size_t DEFAULT_WINDOW_POINTS = 1 << 20;
+
+// The points of a transcript that the transcripts either side of it are checked against. Each vector is empty if the
+// transcript has no such point.
+struct TranscriptBoundary
+{
+    streaming::Manifest manifest;
+    std::vector<G1> g1_first;
+    std::vector<G1> g1_last;
+    std::vector<G2> g2_first;
+    std::vector<G2> g2_last;
+    // Transcript 0's last G2 point is g2^y, so the one before it ends its sequence.
+    std::vector<G2> g2_before_last;
+};
+
+// State a long-lived verifier keeps warm between verifications: the boundary points of recently seen transcripts,
+// and the pairing precomputation of fixed G2 points. Safe to share between threads.
+class VerifierCache
+{
+  public:
+    // The boundary points of the transcript at path, read from disk unless the file is unchanged since they were.
+    std::shared_ptr<const TranscriptBoundary> boundary(std::string const &path);
+
+    pairing::G2PrecomputeCache &g2_precomputes() { return g2_precomputes_; }
+
+  private:
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<const TranscriptBoundary>> boundaries_;
+    std::deque<std::string> boundary_order_;
+    pairing::G2PrecomputeCache g2_precomputes_;
+};
+
+// Default number of points of each group checked before the rest of a transcript by a staged verification.
+constexpr size_t DEFAULT_PREFIX_POINTS = 1 << 12;
+
+// Validates the transcript at transcript_path against the first points of transcript 0 and, if given, the last
+// points of the previous transcript. The transcript is streamed from disk and checked window_points points at a
+// time, so memory use is bounded by the window rather than the transcript. Throws if it is invalid.
+// If prefix_points is non-zero, the verification is staged: the derivation from the previous participant and the
+// first prefix_points points of each group are checked first, so gross errors are rejected within seconds, and
+// only then the whole transcript.
+void verify_transcript(streaming::Manifest &manifest,
+                       std::string const &transcript_path,
+                       std::string const &transcript0_path,
+                       std::string const &transcript_previous_path,
+                       size_t window_points = DEFAULT_WINDOW_POINTS,
+                       bool small_exponents = false,
+                       size_t prefix_points = 0);
+
+// As above, with boundary points and pairing precomputation taken from cache.
+void verify_transcript(VerifierCache &cache,
+                       streaming::Manifest &manifest,
+                       std::string const &transcript_path,
+                       std::string const &transcript0_path,
+                       std::string const &transcript_previous_path,
+                       size_t window_points = DEFAULT_WINDOW_POINTS,
+                       bool small_exponents = false,
+                       size_t prefix_points = 0);
+
+// As verify_transcript, unless ledger records the outcome of verifying the same transcript against the same transcript
+// 0 and previous transcript, in which case that is taken instead. Otherwise the outcome is recorded. Only a
+// VerificationFailure is recorded as invalid: any other error propagates with nothing recorded, so that the
+// transcript is checked again next time. Returns true if the outcome came from the ledger.
+bool verify_recorded_transcript(streaming::TranscriptLedger &ledger,
+                                streaming::Manifest &manifest,
+                                std::string const &transcript_path,
+                                std::string const &transcript0_path,
+                                std::string const &transcript_previous_path,
+                                size_t window_points = DEFAULT_WINDOW_POINTS,
+                                bool small_exponents = false,
+                                size_t prefix_points = 0);
+
+// As above, for a transcript that is still being written: transcript_path is a file that may still be growing, or
+// "-" for stdin. check_manifest is called as soon as the manifest arrives, and may throw to reject it. Points are
+// checked window by window as they arrive, so only the pairings are left once the last byte lands.
+void verify_growing_transcript(VerifierCache &cache,
+                               streaming::Manifest &manifest,
+                               std::string const &transcript_path,
+                               std::string const &transcript0_path,
+                               std::string const &transcript_previous_path,
+                               streaming::ManifestCallback const &check_manifest,
+                               size_t window_points = DEFAULT_WINDOW_POINTS,
+                               bool small_exponents = false,
+                               size_t timeout_seconds = streaming::DEFAULT_FOLLOW_TIMEOUT_SECONDS);
+
+// Validates every transcript of one participant as a whole: each transcript's powering sequence, that each
+// continues on from the one before, and, if previous_transcript0_path is given, that transcript 0 was derived from
+// the previous participant's. Transcripts are streamed a few at a time, each holding at most window_points decoded
+// points of a group in memory, and all the checks end in a single product of pairings. Throws if any fail.
+void verify_transcripts(streaming::TranscriptSet const &set,
+                        std::string const &previous_transcript0_path,
+                        size_t window_points = DEFAULT_WINDOW_POINTS,
+                        bool small_exponents = false);
+
+// Validates a ceremony history: the transcripts of each participant in sets as verify_transcripts does, and that
+// each participant's transcript 0 was derived from the one before, the first from previous_transcript0_path if
+// given. Transcripts of different participants stream together, a few at a time, and every check of every
+// participant ends in a single product of pairings. Errors name the participant that failed, by its position.
+void verify_chain(std::vector<streaming::TranscriptSet> const &sets,
+                  std::string const &previous_transcript0_path,
+                  size_t window_points = DEFAULT_WINDOW_POINTS,
+                  bool small_exponents = false);
+
+// The partial keys of one range of a transcript's points, for each group.
+struct TranscriptPartial
+{
+    PartialKey<G1> g1;
+    PartialKey<G2> g2;
+};
+
+// Accumulates points first_point, ..., first_point + num_points - 1 of each group of the transcript at
+// transcript_path, weighted by seed, and returns their partial keys. Points are read window_points at a time and
+// checked to be in their subgroup, but the checksum is not checked. Processes sharing a seed can split a
+// transcript's points between them, and their partials are combined by verify_combine.
+TranscriptPartial verify_partial(std::string const &transcript_path,
+                                 std::vector<unsigned char> const &seed,
+                                 size_t first_point,
+                                 size_t num_points,
+                                 size_t window_points = DEFAULT_WINDOW_POINTS,
+                                 bool small_exponents = false);
+
+// Validates the transcript as verify_transcript does, with its sequences taken from partials computed with seed,
+// which must cover each group's points exactly once. The transcript is hashed to validate its checksum, but its
+// points are not read. Throws if it is invalid.
+void verify_combine(streaming::Manifest &manifest,
+                    std::string const &transcript_path,
+                    std::string const &transcript0_path,
+                    std::string const &transcript_previous_path,
+                    std::vector<unsigned char> const &seed,
+                    std::vector<TranscriptPartial> const &partials,
+                    bool small_exponents = false);
+
+// Writes a partial as one line of text, beginning "partial", with each point as the hex of its transcript encoding.
+void write_partial(std::ostream &os, TranscriptPartial const &partial);
+
+TranscriptPartial read_partial(std::string const &line);
 
 bool validate_manifest(streaming::Manifest const &manifest, size_t total_g1_points, size_t total_g2_points, size_t points_per_transcript, size_t transcript_number);
\ No newline at end of file
@@ -5,6 +5,26 @@
 #include <aztec_common/streaming_transcript.hpp>
 #include <aztec_common/streaming_g1.hpp>
 #include <aztec_common/streaming_g2.hpp>
+#include <aztec_common/transcript_writer.hpp>
+#include <aztec_common/async_io.hpp>
+#include <aztec_common/field_conversion.hpp>
+#include <aztec_common/multi_pairing.hpp>
+#include <aztec_common/streaming_bberg.hpp>
+#include <aztec_common/pippenger.hpp>
+#include <aztec_common/pippenger_bberg.hpp>
+#include <aztec_common/point_checks.hpp>
+#include <aztec_common/thread_pool.hpp>
+#include <aztec_common/transcript_ledger.hpp>
+#include <aztec_common/transcript_query.hpp>
+#include <aztec_common/transcript_reshard.hpp>
+#include <aztec_common/transcript_set.hpp>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
 #include "test_utils.hpp"
 
 TEST(aztec_common, variable_size_checks)
@@ -147,3 +167,910 @@ TEST(streaming, read_write_transcripts)
         test_utils::validate_g2_point<num_limbs>(g2_result[i], g2_expected[i]);
     }
 }
+
+TEST(streaming, write_transcript_matches_buffered_transcript)
+{
+    constexpr size_t G1_N = 5000;
+    constexpr size_t G2_N = 2;
+    constexpr size_t manifest_size = sizeof(streaming::Manifest);
+    constexpr size_t g1_buffer_size = sizeof(Fq) * 2 * G1_N;
+    constexpr size_t g2_buffer_size = sizeof(Fqe) * 2 * G2_N;
+
+    libff::init_alt_bn128_params();
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    streaming::Manifest manifest;
+
+    manifest.transcript_number = 0;
+    manifest.total_transcripts = 1;
+    manifest.total_g1_points = G1_N;
+    manifest.total_g2_points = G2_N;
+    manifest.num_g1_points = G1_N;
+    manifest.num_g2_points = G2_N;
+    manifest.start_from = 0;
+
+    G1 g1_point = G1::random_element();
+    g1_point.to_affine_coordinates();
+    for (size_t i = 0; i < G1_N; ++i)
+    {
+        g1_x.emplace_back(g1_point);
+        g1_point = g1_point + g1_point;
+        g1_point.to_affine_coordinates();
+    }
+    for (size_t i = 0; i < G2_N; ++i)
+    {
+        G2 g2_point = G2::random_element();
+        g2_point.to_affine_coordinates();
+        g2_x.emplace_back(g2_point);
+    }
+
+    // The transcript as it would be built entirely in memory.
+    std::vector<char> expected(streaming::get_transcript_size(manifest));
+    streaming::Manifest net_manifest;
+    net_manifest.transcript_number = htonl(manifest.transcript_number);
+    net_manifest.total_transcripts = htonl(manifest.total_transcripts);
+    net_manifest.total_g1_points = htonl(manifest.total_g1_points);
+    net_manifest.total_g2_points = htonl(manifest.total_g2_points);
+    net_manifest.num_g1_points = htonl(manifest.num_g1_points);
+    net_manifest.num_g2_points = htonl(manifest.num_g2_points);
+    net_manifest.start_from = htonl(manifest.start_from);
+    memcpy(&expected[0], &net_manifest, manifest_size);
+    streaming::write_g1_elements_to_buffer(g1_x, &expected[manifest_size]);
+    streaming::write_g2_elements_to_buffer(g2_x, &expected[manifest_size + g1_buffer_size]);
+    streaming::add_checksum_to_buffer(&expected[0], manifest_size + g1_buffer_size + g2_buffer_size);
+
+    streaming::write_transcript(g1_x, g2_x, manifest, "/tmp/wtb_test");
+    std::vector<char> result = streaming::read_file_into_buffer("/tmp/wtb_test");
+
+    EXPECT_EQ(result.size(), expected.size());
+    EXPECT_EQ(result, expected);
+}
+
+TEST(streaming, transcript_writer_checksums_across_blocks)
+{
+    std::vector<char> data(10007);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (char)(i * 131);
+    }
+
+    {
+        // Tiny blocks, so writes straddle block boundaries and the ring wraps many times.
+        streaming::TranscriptWriter writer("/tmp/tw_test", false, false, 100, 3);
+        for (size_t i = 0; i < data.size(); i += 37)
+        {
+            writer.write(&data[i], std::min((size_t)37, data.size() - i));
+        }
+        writer.finish();
+    }
+
+    std::vector<char> result = streaming::read_file_into_buffer("/tmp/tw_test");
+    EXPECT_EQ(result.size(), data.size() + checksum::BLAKE2B_CHECKSUM_LENGTH);
+    EXPECT_NO_THROW(streaming::validate_checksum(result));
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), result.begin()));
+}
+
+TEST(streaming, async_io_delivers_chunks_in_order)
+{
+    std::vector<char> data(3 * 4096 * 5 + 17);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (char)(i * 7 + i / 4096);
+    }
+
+    const streaming::AsyncIoBackend backends[] = {streaming::AsyncIoBackend::AUTO, streaming::AsyncIoBackend::THREADS};
+    for (auto backend : backends)
+    {
+        // Smallest buffers and a shallow queue, so requests split into many chunks that complete out of order.
+        auto io = streaming::create_async_io(3, 4096, backend);
+        remove("/tmp/aio_test");
+        io->write({{"/tmp/aio_test", 0, &data[0], data.size()}});
+
+        std::vector<streaming::ReadRequest> requests = {
+            {"/tmp/aio_test", 0, 28},
+            {"/tmp/aio_test", 28, 4096 * 7},
+            {"/tmp/aio_test", 28 + 4096 * 7, data.size() - 28 - 4096 * 7},
+        };
+        std::vector<char> result;
+        size_t expected_request = 0;
+        size_t expected_offset = 0;
+        io->read(requests, [&](size_t request, size_t request_offset, char const *chunk, size_t size) {
+            if (request != expected_request)
+            {
+                expected_request = request;
+                expected_offset = 0;
+            }
+            EXPECT_EQ(request_offset, expected_offset);
+            expected_offset += size;
+            result.insert(result.end(), chunk, chunk + size);
+        });
+
+        EXPECT_EQ(expected_request, requests.size() - 1);
+        EXPECT_EQ(result, data);
+        EXPECT_THROW(io->read({{"/tmp/aio_test", data.size() - 10, 100}}, [](size_t, size_t, char const *, size_t) {}), std::runtime_error);
+    }
+}
+
+TEST(streaming, read_transcript_rejects_corrupted_transcript)
+{
+    libff::init_alt_bn128_params();
+    std::vector<G1> g1_x(3, G1::one());
+    std::vector<G2> g2_x(2, G2::one());
+    streaming::Manifest manifest;
+
+    manifest.transcript_number = 0;
+    manifest.total_transcripts = 1;
+    manifest.total_g1_points = 3;
+    manifest.total_g2_points = 2;
+    manifest.num_g1_points = 3;
+    manifest.num_g2_points = 2;
+    manifest.start_from = 0;
+    streaming::write_transcript(g1_x, g2_x, manifest, "/tmp/rct_test");
+
+    std::vector<G1> g1_result;
+    std::vector<G2> g2_result;
+    EXPECT_NO_THROW(streaming::read_transcript(g1_result, g2_result, manifest, "/tmp/rct_test"));
+    EXPECT_EQ(streaming::read_checksum("/tmp/rct_test").size(), checksum::BLAKE2B_CHECKSUM_LENGTH);
+
+    // Flip a bit in the last G2 point.
+    std::vector<char> buffer = streaming::read_file_into_buffer("/tmp/rct_test");
+    buffer[buffer.size() - checksum::BLAKE2B_CHECKSUM_LENGTH - 1] ^= 1;
+    streaming::write_buffer_to_file("/tmp/rct_test", buffer);
+    EXPECT_THROW(streaming::read_checksum("/tmp/rct_test"), std::runtime_error);
+
+    // A transcript that is shorter than its manifest says.
+    buffer.resize(buffer.size() - 1);
+    streaming::write_buffer_to_file("/tmp/rct_test", buffer);
+    g1_result.clear();
+    g2_result.clear();
+    EXPECT_THROW(streaming::read_transcript(g1_result, g2_result, manifest, "/tmp/rct_test"), std::runtime_error);
+}
+
+TEST(field_conversion, matches_libff_conversions)
+{
+    constexpr size_t N = 37;
+    constexpr size_t num_limbs = sizeof(Fq) / GMP_NUMB_BYTES;
+
+    libff::init_alt_bn128_params();
+    std::vector<Fq> elements;
+    for (size_t i = 0; i < N - 2; ++i)
+    {
+        elements.push_back(Fq::random_element());
+    }
+    elements.push_back(Fq::zero());
+    elements.push_back(-Fq::one());
+
+    std::vector<char> expected(N * sizeof(Fq));
+    for (size_t i = 0; i < N; ++i)
+    {
+        libff::bigint<num_limbs> value = elements[i].as_bigint();
+        streaming::write_bigint_to_buffer<num_limbs>(value, &expected[i * sizeof(Fq)]);
+    }
+
+    // Offset by one byte, as the kernels must cope with unaligned transcript buffers.
+    std::vector<char> encoded(N * sizeof(Fq) + 1);
+    field_conversion::encode_field_elements(&encoded[1], &elements[0], N);
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), encoded.begin() + 1));
+
+    std::vector<Fq> decoded(N);
+    field_conversion::decode_field_elements(&decoded[0], &encoded[1], N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        EXPECT_EQ(decoded[i], elements[i]);
+    }
+
+    // Out of range inputs reduce exactly as libff's bigint constructor does.
+    libff::bigint<num_limbs> all_ones;
+    for (size_t i = 0; i < num_limbs; ++i)
+    {
+        all_ones.data[i] = ~(mp_limb_t)0;
+    }
+    std::vector<char> all_ones_buffer(sizeof(Fq), (char)0xff);
+    Fq reduced;
+    field_conversion::decode_field_elements(&reduced, &all_ones_buffer[0], 1);
+    EXPECT_EQ(reduced, Fq(all_ones));
+}
+
+TEST(streaming, bberg_transcript_matches_libff_transcript)
+{
+    constexpr size_t G1_N = 100;
+    constexpr size_t G2_N = 2;
+
+    libff::init_alt_bn128_params();
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    streaming::Manifest manifest;
+
+    manifest.transcript_number = 0;
+    manifest.total_transcripts = 1;
+    manifest.total_g1_points = G1_N;
+    manifest.total_g2_points = G2_N;
+    manifest.num_g1_points = G1_N;
+    manifest.num_g2_points = G2_N;
+    manifest.start_from = 0;
+
+    for (size_t i = 0; i < G1_N; ++i)
+    {
+        G1 g1_point = G1::random_element();
+        g1_point.to_affine_coordinates();
+        g1_x.emplace_back(g1_point);
+    }
+    for (size_t i = 0; i < G2_N; ++i)
+    {
+        G2 g2_point = G2::random_element();
+        g2_point.to_affine_coordinates();
+        g2_x.emplace_back(g2_point);
+    }
+    streaming::write_transcript(g1_x, g2_x, manifest, "/tmp/bbt_libff_test");
+
+    std::vector<bb::g1::affine_element> g1_result;
+    std::vector<bb::g2::affine_element> g2_result;
+    streaming::read_transcript_bberg(g1_result, g2_result, manifest, "/tmp/bbt_libff_test");
+    EXPECT_EQ(g1_result.size(), G1_N);
+    EXPECT_EQ(g2_result.size(), G2_N);
+
+    // libff and barretenberg share a Montgomery representation, so affine coordinates compare bytewise.
+    for (size_t i = 0; i < G1_N; ++i)
+    {
+        EXPECT_EQ(memcmp(&g1_result[i].x, &g1_x[i].X, sizeof(Fq)), 0);
+        EXPECT_EQ(memcmp(&g1_result[i].y, &g1_x[i].Y, sizeof(Fq)), 0);
+    }
+    for (size_t i = 0; i < G2_N; ++i)
+    {
+        EXPECT_EQ(memcmp(&g2_result[i].x, &g2_x[i].X, sizeof(Fqe)), 0);
+        EXPECT_EQ(memcmp(&g2_result[i].y, &g2_x[i].Y, sizeof(Fqe)), 0);
+    }
+
+    std::vector<bb::g1::affine_element> last_g1;
+    streaming::read_transcript_bberg_g1_points(last_g1, "/tmp/bbt_libff_test", -1, 1);
+    EXPECT_EQ(memcmp(&last_g1[0], &g1_result[G1_N - 1], sizeof(bb::g1::affine_element)), 0);
+
+    streaming::write_transcript_bberg(g1_result, g2_result, manifest, "/tmp/bbt_bberg_test");
+    EXPECT_EQ(streaming::read_file_into_buffer("/tmp/bbt_bberg_test"), streaming::read_file_into_buffer("/tmp/bbt_libff_test"));
+}
+
+TEST(parallel, nested_parallel_for)
+{
+    parallel::ThreadPool pool(4);
+    std::atomic<size_t> sum(0);
+    pool.parallel_for(20, [&](size_t i) {
+        pool.parallel_for(10, [&](size_t j) { sum += i * 10 + j; });
+    });
+    EXPECT_EQ(sum.load(), (size_t)(200 * 199 / 2));
+
+    EXPECT_THROW(pool.parallel_for(100, [](size_t i) {
+        if (i == 7)
+        {
+            throw std::runtime_error("failed");
+        }
+    }),
+                 std::runtime_error);
+}
+
+TEST(streaming, load_transcript_set)
+{
+    constexpr size_t POINTS_PER_FILE = 5;
+    constexpr size_t G1_N = 13;
+    constexpr size_t G2_N = 2;
+    const std::string dir = "/tmp/tset_test";
+
+    libff::init_alt_bn128_params();
+    mkdir(dir.c_str(), 0755);
+    std::vector<G1> g1_expected;
+    for (size_t i = 0; i < G1_N; ++i)
+    {
+        G1 g1_point = G1::random_element();
+        g1_point.to_affine_coordinates();
+        g1_expected.emplace_back(g1_point);
+    }
+
+    const size_t num_transcripts = 3;
+    for (size_t i = 0; i < num_transcripts; ++i)
+    {
+        streaming::Manifest manifest;
+        manifest.transcript_number = i;
+        manifest.total_transcripts = num_transcripts;
+        manifest.total_g1_points = G1_N;
+        manifest.total_g2_points = G2_N;
+        manifest.start_from = i * POINTS_PER_FILE;
+        manifest.num_g1_points = std::min(POINTS_PER_FILE, G1_N - manifest.start_from);
+        manifest.num_g2_points = i == 0 ? G2_N : 0;
+        std::vector<G1> g1_x(g1_expected.begin() + manifest.start_from, g1_expected.begin() + manifest.start_from + manifest.num_g1_points);
+        std::vector<G2> g2_x(manifest.num_g2_points, G2::one());
+        streaming::write_transcript(g1_x, g2_x, manifest, streaming::getTranscriptInPath(dir, i));
+    }
+    remove(streaming::getTranscriptInPath(dir, num_transcripts).c_str());
+
+    streaming::TranscriptSet set = streaming::find_transcripts(dir);
+    EXPECT_EQ(set.size(), num_transcripts);
+    EXPECT_EQ(set.num_g1_points(), G1_N);
+    EXPECT_EQ(set.num_g2_points(), G2_N);
+
+    std::vector<G1> g1_result(1, G1::one());
+    streaming::load_transcripts_g1_points(set, g1_result, 2);
+    EXPECT_EQ(g1_result.size(), G1_N + 1);
+    for (size_t i = 0; i < G1_N; ++i)
+    {
+        EXPECT_EQ(g1_result[i + 1], g1_expected[i]);
+    }
+
+    auto checksums = streaming::read_transcript_checksums(set);
+    for (size_t i = 0; i < num_transcripts; ++i)
+    {
+        EXPECT_EQ(checksums[i], streaming::read_checksum(set.paths[i]));
+    }
+
+    // A missing transcript leaves the set incomplete.
+    remove(streaming::getTranscriptInPath(dir, 2).c_str());
+    EXPECT_THROW(streaming::find_transcripts(dir), std::runtime_error);
+}
+
+TEST(streaming, reshard_transcripts)
+{
+    constexpr size_t POINTS_PER_FILE = 5;
+    constexpr size_t G1_N = 13;
+    constexpr size_t G2_N = 7;
+    const std::string in_dir = "/tmp/reshard_in_test";
+    const std::string out_dir = "/tmp/reshard_out_test";
+
+    libff::init_alt_bn128_params();
+    mkdir(in_dir.c_str(), 0755);
+    mkdir(out_dir.c_str(), 0755);
+    std::vector<G1> g1_expected;
+    std::vector<G2> g2_expected;
+    for (size_t i = 0; i < G1_N; ++i)
+    {
+        G1 g1_point = G1::random_element();
+        g1_point.to_affine_coordinates();
+        g1_expected.emplace_back(g1_point);
+    }
+    for (size_t i = 0; i < G2_N + 1; ++i)
+    {
+        G2 g2_point = G2::random_element();
+        g2_point.to_affine_coordinates();
+        g2_expected.emplace_back(g2_point);
+    }
+    const G2 g2_y = g2_expected.back();
+    g2_expected.pop_back();
+
+    const size_t num_transcripts = 3;
+    for (size_t i = 0; i < num_transcripts; ++i)
+    {
+        streaming::Manifest manifest;
+        manifest.transcript_number = i;
+        manifest.total_transcripts = num_transcripts;
+        manifest.total_g1_points = G1_N;
+        manifest.total_g2_points = G2_N;
+        manifest.start_from = i * POINTS_PER_FILE;
+        manifest.num_g1_points = std::min(POINTS_PER_FILE, G1_N - manifest.start_from);
+        manifest.num_g2_points = std::min(POINTS_PER_FILE, G2_N > manifest.start_from ? G2_N - manifest.start_from : 0);
+        std::vector<G1> g1_x(g1_expected.begin() + manifest.start_from, g1_expected.begin() + manifest.start_from + manifest.num_g1_points);
+        std::vector<G2> g2_x(g2_expected.begin() + manifest.start_from, g2_expected.begin() + manifest.start_from + manifest.num_g2_points);
+        if (i == 0)
+        {
+            manifest.num_g2_points += 1;
+            g2_x.push_back(g2_y);
+        }
+        streaming::write_transcript(g1_x, g2_x, manifest, streaming::getTranscriptInPath(in_dir, i));
+    }
+    remove(streaming::getTranscriptInPath(in_dir, num_transcripts).c_str());
+    auto set = streaming::find_transcripts(in_dir);
+
+    // Keep 11 points, 4 to a transcript.
+    constexpr size_t NEW_POINTS_PER_FILE = 4;
+    constexpr size_t MAX_POINTS = 11;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        remove(streaming::getTranscriptInPath(out_dir, i).c_str());
+    }
+    auto manifests = streaming::reshard_transcripts(set, out_dir, NEW_POINTS_PER_FILE, MAX_POINTS);
+    EXPECT_EQ(manifests.size(), 3UL);
+
+    auto resharded = streaming::find_transcripts(out_dir);
+    EXPECT_EQ(resharded.size(), 3UL);
+    EXPECT_EQ(resharded.num_g1_points(), MAX_POINTS);
+    EXPECT_EQ(resharded.num_g2_points(), G2_N + 1);
+
+    std::vector<G1> g1_result;
+    std::vector<G2> g2_result;
+    for (size_t i = 0; i < resharded.size(); ++i)
+    {
+        streaming::Manifest manifest;
+        streaming::read_transcript(g1_result, g2_result, manifest, resharded.paths[i]);
+        EXPECT_EQ(manifest.start_from, i * NEW_POINTS_PER_FILE);
+        EXPECT_EQ(manifest.total_g2_points, G2_N);
+        if (i == 0)
+        {
+            EXPECT_EQ(g2_result.back(), g2_y);
+            g2_result.pop_back();
+        }
+    }
+    EXPECT_EQ(g1_result.size(), MAX_POINTS);
+    for (size_t i = 0; i < MAX_POINTS; ++i)
+    {
+        EXPECT_EQ(g1_result[i], g1_expected[i]);
+    }
+    EXPECT_EQ(g2_result.size(), G2_N);
+    for (size_t i = 0; i < G2_N; ++i)
+    {
+        EXPECT_EQ(g2_result[i], g2_expected[i]);
+    }
+
+    // Resharding over the input would destroy it while it is being read.
+    EXPECT_THROW(streaming::reshard_transcripts(set, in_dir, NEW_POINTS_PER_FILE), std::runtime_error);
+}
+
+TEST(streaming, transcript_ledger)
+{
+    const std::string ledger_path = "/tmp/ledger_test.dat";
+    const std::string good_path = "/tmp/ledger_good_transcript.dat";
+    const std::string bad_path = "/tmp/ledger_bad_transcript.dat";
+    remove(ledger_path.c_str());
+
+    libff::init_alt_bn128_params();
+    streaming::Manifest manifest;
+    manifest.transcript_number = 0;
+    manifest.total_transcripts = 1;
+    manifest.total_g1_points = 3;
+    manifest.total_g2_points = 1;
+    manifest.num_g1_points = 3;
+    manifest.num_g2_points = 2;
+    manifest.start_from = 0;
+
+    std::vector<G1> g1_x;
+    for (size_t i = 0; i < manifest.num_g1_points; ++i)
+    {
+        G1 point = G1::random_element();
+        point.to_affine_coordinates();
+        g1_x.push_back(point);
+    }
+    std::vector<G2> g2_x(manifest.num_g2_points, G2::one());
+    streaming::write_transcript(g1_x, g2_x, manifest, good_path);
+
+    // Knock a point off the curve.
+    std::vector<G1> bad_g1_x(g1_x);
+    bad_g1_x[1].Y = bad_g1_x[1].Y + Fq::one();
+    streaming::write_transcript(bad_g1_x, g2_x, manifest, bad_path);
+
+    streaming::LedgerEntry entry;
+    entry.checksum = streaming::read_checksum(bad_path);
+    entry.manifest = manifest;
+    entry.transcript0_checksum = entry.checksum;
+    entry.valid = true;
+    {
+        streaming::TranscriptLedger ledger(ledger_path);
+        EXPECT_EQ(ledger.size(), 0UL);
+        std::vector<G1> g1_result;
+        std::vector<G2> g2_result;
+        streaming::Manifest result_manifest;
+        EXPECT_THROW(streaming::read_trusted_transcript(g1_result, g2_result, result_manifest, bad_path, ledger), std::runtime_error);
+        ledger.append(entry);
+    }
+    const size_t record_size = streaming::get_file_size(ledger_path);
+
+    // A torn record at the end of the ledger is ignored, and dropped by the next append.
+    {
+        std::ofstream ledger_file(ledger_path, std::ios::app | std::ios::binary);
+        ledger_file.write("torn", 4);
+    }
+
+    streaming::TranscriptLedger ledger(ledger_path);
+    EXPECT_EQ(ledger.size(), 1UL);
+    EXPECT_TRUE(ledger.is_verified(entry.checksum));
+    EXPECT_FALSE(ledger.is_verified(streaming::read_checksum(good_path)));
+    auto found = ledger.find(entry.checksum, entry.checksum, std::vector<char>());
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->manifest.num_g1_points, manifest.num_g1_points);
+    EXPECT_TRUE(found->valid);
+    EXPECT_EQ(ledger.find(entry.checksum, entry.checksum, entry.checksum), nullptr);
+
+    // The ledger's word is taken for the bad transcript, so its points are not checked.
+    std::vector<G1> g1_result;
+    std::vector<G2> g2_result;
+    streaming::Manifest result_manifest;
+    streaming::read_trusted_transcript(g1_result, g2_result, result_manifest, bad_path, ledger);
+    EXPECT_EQ(g1_result[1], bad_g1_x[1]);
+
+    // Untrusted transcripts are checked after loading.
+    g1_result.clear();
+    g2_result.clear();
+    streaming::read_trusted_transcript(g1_result, g2_result, result_manifest, good_path, ledger);
+    EXPECT_EQ(g1_result, g1_x);
+    EXPECT_EQ(g2_result.size(), manifest.num_g2_points);
+
+    entry.checksum = streaming::read_checksum(good_path);
+    entry.valid = false;
+    ledger.append(entry);
+    EXPECT_EQ(streaming::TranscriptLedger(ledger_path).size(), 2UL);
+    EXPECT_EQ(streaming::get_file_size(ledger_path), 2 * record_size);
+}
+
+// Appends value as 32 big-endian bytes, as print_point --batch --binary writes it.
+void append_big_endian(std::string &out, Fq const &value)
+{
+    auto bigint = value.as_bigint();
+    for (size_t i = 32; i-- > 0;)
+    {
+        out += (char)(bigint.data[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+TEST(streaming, point_queries)
+{
+    constexpr size_t G1_N = 2500;
+    constexpr size_t G2_N = 2;
+    const std::string paths[] = { "/tmp/query_test_transcript0.dat", "/tmp/query_test_transcript1.dat" };
+
+    libff::init_alt_bn128_params();
+    G1 g1_point = G1::random_element();
+    const G1 g1_step = G1::random_element();
+    for (size_t i = 0; i < 2; ++i)
+    {
+        streaming::Manifest manifest;
+        manifest.transcript_number = i;
+        manifest.total_transcripts = 2;
+        manifest.total_g1_points = 2 * G1_N;
+        manifest.total_g2_points = G2_N;
+        manifest.num_g1_points = G1_N;
+        manifest.num_g2_points = G2_N;
+        manifest.start_from = i * G1_N;
+
+        std::vector<G1> g1_x;
+        for (size_t j = 0; j < G1_N; ++j)
+        {
+            g1_point = g1_point + g1_step;
+            G1 point = g1_point;
+            point.to_affine_coordinates();
+            g1_x.push_back(point);
+        }
+        std::vector<G2> g2_x;
+        for (size_t j = 0; j < G2_N; ++j)
+        {
+            G2 point = G2::random_element();
+            point.to_affine_coordinates();
+            g2_x.push_back(point);
+        }
+        streaming::write_transcript(g1_x, g2_x, manifest, paths[i]);
+    }
+    std::vector<std::string> path_list(paths, paths + 2);
+
+    std::vector<G1> g1_expected;
+    std::vector<G2> g2_expected;
+    streaming::read_transcript_g1_points(g1_expected, paths[0], 1000, 1101);
+    streaming::read_transcript_g1_points(g1_expected, paths[1], 0, 1501);
+    streaming::read_transcript_g1_points(g1_expected, paths[0], 5, 1);
+    streaming::read_transcript_g2_points(g2_expected, paths[1], 0, 2);
+    std::string expected;
+    for (auto &point : g1_expected)
+    {
+        point.to_affine_coordinates();
+        append_big_endian(expected, point.X);
+        append_big_endian(expected, point.Y);
+    }
+    for (auto &point : g2_expected)
+    {
+        point.to_affine_coordinates();
+        append_big_endian(expected, point.X.c0);
+        append_big_endian(expected, point.X.c1);
+        append_big_endian(expected, point.Y.c0);
+        append_big_endian(expected, point.Y.c1);
+    }
+
+    // Ranges longer than a piece, in both transcripts, and more pieces than are decoded in a round.
+    const std::vector<std::string> queries = { "0:g1:1000-2100", "1:g1:0-1500", "g1:5", "1:g2:0-1" };
+    std::vector<std::unique_ptr<streaming::MappedTranscript>> transcripts;
+    for (auto const &path : path_list)
+    {
+        transcripts.emplace_back(new streaming::MappedTranscript(path));
+    }
+    std::vector<streaming::PointQuery> parsed;
+    for (auto const &query : queries)
+    {
+        parsed.push_back(streaming::parse_point_query(query, transcripts));
+    }
+    auto pieces = streaming::split_point_queries(parsed);
+    ASSERT_EQ(pieces.size(), 6UL);
+    EXPECT_EQ(pieces[1].first, 1000 + streaming::POINTS_PER_PIECE);
+    EXPECT_EQ(pieces[1].count, 1101 - streaming::POINTS_PER_PIECE);
+    EXPECT_EQ(pieces[3].transcript, 1UL);
+    EXPECT_TRUE(pieces[5].g2);
+
+    std::ostringstream binary;
+    streaming::write_point_queries(path_list, queries, true, binary, 4);
+    EXPECT_EQ(binary.str(), expected);
+
+    std::ostringstream json;
+    streaming::write_point_queries(path_list, queries, false, json, 4);
+    const std::string json_out = json.str();
+    EXPECT_EQ((size_t)std::count(json_out.begin(), json_out.end(), '\n'), g1_expected.size() + g2_expected.size());
+    char first[256];
+    gmp_snprintf(first, sizeof(first), "{\"transcript\":0,\"group\":\"g1\",\"index\":1000,\"point\":[\"0x%064Nx\",\"0x%064Nx\"]}\n",
+                 g1_expected[0].X.as_bigint().data, 4L,
+                 g1_expected[0].Y.as_bigint().data, 4L);
+    EXPECT_EQ(json_out.substr(0, json_out.find('\n') + 1), first);
+
+    // Malformed queries, and queries past the end of the transcripts, are rejected before anything is written.
+    const std::vector<std::string> bad_queries = { "g3:1", "g1", "g1:5-3", "g1:x", "0:g1:1:2", "2:g1:0", "0:g1:2500", "1:g2:0-2" };
+    for (auto const &query : bad_queries)
+    {
+        EXPECT_THROW(streaming::parse_point_query(query, transcripts), std::runtime_error) << query;
+        std::ostringstream out;
+        EXPECT_THROW(streaming::write_point_queries(path_list, { "g1:0", query }, true, out), std::runtime_error) << query;
+        EXPECT_TRUE(out.str().empty());
+    }
+}
+
+template <typename GroupT>
+void check_pippenger_matches_naive(size_t num_points)
+{
+    std::vector<GroupT> points;
+    std::vector<Fq> scalars;
+    GroupT expected = GroupT::zero();
+    for (size_t i = 0; i < num_points; ++i)
+    {
+        GroupT point = GroupT::random_element();
+        // Mix affine and projective points, which take different addition paths.
+        if (i % 2)
+        {
+            point.to_affine_coordinates();
+        }
+        points.push_back(point);
+        scalars.push_back(Fq::random_element());
+        expected = expected + scalars.back().as_bigint() * point;
+    }
+    EXPECT_EQ(pippenger::multi_exp(points.data(), scalars.data(), num_points), expected);
+}
+
+TEST(pippenger, matches_naive_multi_exp)
+{
+    libff::init_alt_bn128_params();
+    for (size_t num_points : std::vector<size_t>{0, 1, 2, 33, 2 * pippenger::MIN_POINTS_PER_THREAD + 1})
+    {
+        check_pippenger_matches_naive<G1>(num_points);
+    }
+    for (size_t num_points : std::vector<size_t>{0, 1, 33})
+    {
+        check_pippenger_matches_naive<G2>(num_points);
+    }
+
+    // Short scalars only pay for the bits they have.
+    std::vector<G1> points(100, G1::one());
+    std::vector<Fq> scalars(100, Fq(3));
+    EXPECT_EQ(pippenger::multi_exp(points.data(), scalars.data(), 100), Fq(300).as_bigint() * G1::one());
+}
+
+TEST(pippenger, bberg_multi_exp_across_threads)
+{
+    libff::init_alt_bn128_params();
+    for (size_t num_points : std::vector<size_t>{1, 2 * pippenger::MIN_POINTS_PER_THREAD + 1})
+    {
+        std::vector<G1> points;
+        std::vector<Fr> scalars;
+        for (size_t i = 0; i < num_points; ++i)
+        {
+            points.push_back(G1::random_element());
+            points.back().to_affine_coordinates();
+            scalars.push_back(Fr::random_element());
+        }
+        G1 expected = pippenger::multi_exp(points.data(), scalars.data(), num_points);
+        expected.to_affine_coordinates();
+
+        // libff and barretenberg share a Montgomery representation, so points and scalars copy over bytewise.
+        std::vector<bb::g1::affine_element> bb_points(num_points);
+        std::vector<bb::fr::field_t> bb_scalars(num_points);
+        for (size_t i = 0; i < num_points; ++i)
+        {
+            memcpy(&bb_points[i].x, &points[i].X, sizeof(Fq));
+            memcpy(&bb_points[i].y, &points[i].Y, sizeof(Fq));
+            memcpy(&bb_scalars[i], &scalars[i], sizeof(Fr));
+        }
+
+        for (bool copy_scalars : {true, false})
+        {
+            std::vector<bb::fr::field_t> work(bb_scalars);
+            bb::g1::element result = pippenger::multi_exp_bberg(bb_points.data(), work.data(), num_points, copy_scalars);
+            bb::g1::affine_element affine;
+            bb::g1::jacobian_to_affine(result, affine);
+            EXPECT_EQ(memcmp(&affine.x, &expected.X, sizeof(Fq)), 0);
+            EXPECT_EQ(memcmp(&affine.y, &expected.Y, sizeof(Fq)), 0);
+            if (copy_scalars)
+            {
+                EXPECT_EQ(memcmp(work.data(), bb_scalars.data(), num_points * sizeof(bb::fr::field_t)), 0);
+            }
+        }
+    }
+}
+
+TEST(point_checks, on_curve)
+{
+    libff::init_alt_bn128_params();
+    std::vector<G1> g1_x(5000);
+    std::vector<G2> g2_x(100);
+    for (auto &point : g1_x)
+    {
+        point = G1::random_element();
+    }
+    for (auto &point : g2_x)
+    {
+        point = G2::random_element();
+    }
+    EXPECT_TRUE(point_checks::on_curve(g1_x.data(), g1_x.size()));
+    EXPECT_TRUE(point_checks::on_curve(g2_x.data(), g2_x.size()));
+
+    g1_x[4321].X = g1_x[4321].X + Fq::one();
+    g2_x[99] = G2::zero();
+    EXPECT_FALSE(point_checks::on_curve(g1_x.data(), g1_x.size()));
+    EXPECT_FALSE(point_checks::on_curve(g2_x.data(), g2_x.size()));
+}
+
+TEST(point_checks, g2_subgroup_membership)
+{
+    libff::init_alt_bn128_params();
+    G2 point = G2::random_element();
+    EXPECT_TRUE(point_checks::in_subgroup(point));
+    EXPECT_EQ(point_checks::psi(point), Fq::mod * point);
+
+    // A point on the twist curve with a component of every order dividing the cofactor, and its component of order
+    // 10069, the smallest prime factor of the cofactor.
+    G2 outside(Fqe(Fq::one(), Fq::zero()),
+               Fqe(Fq("18278151005453108793778860132295291098363647455926340152056652516292830556603"),
+                   Fq("5912654199736721486680175016176231956195085055698687135131307249486702594212")),
+               Fqe::one());
+    G2 small_order = libff::bigint<8>("47581207271489010074683488451353534690560365133687637544587129035065060451520145913692443394996527310200940637954806362563397135354136976255533127257") * outside;
+    small_order.to_affine_coordinates();
+    ASSERT_TRUE(outside.is_well_formed());
+    ASSERT_TRUE(small_order.is_well_formed());
+    ASSERT_FALSE(small_order.is_zero());
+    EXPECT_FALSE(point_checks::in_subgroup(outside));
+    EXPECT_FALSE(point_checks::in_subgroup(small_order));
+    EXPECT_FALSE(point_checks::in_subgroup(outside + point));
+
+    // Batched, and checked one at a time.
+    for (size_t num_points : std::vector<size_t>{5, 1000})
+    {
+        std::vector<G2> g2_x(num_points);
+        for (auto &p : g2_x)
+        {
+            p = G2::random_element();
+            p.to_affine_coordinates();
+        }
+        EXPECT_TRUE(point_checks::in_subgroup(g2_x.data(), g2_x.size()));
+
+        g2_x[num_points / 2] = small_order;
+        EXPECT_FALSE(point_checks::in_subgroup(g2_x.data(), g2_x.size()));
+        g2_x[num_points / 2] = outside;
+        EXPECT_FALSE(point_checks::in_subgroup(g2_x.data(), g2_x.size()));
+    }
+}
+
+TEST(pairing, multi_pairing)
+{
+    libff::init_alt_bn128_params();
+    Fr a = Fr::random_element();
+    Fr b = Fr::random_element();
+    G1 p = a * G1::one();
+    G2 q = b * G2::one();
+
+    pairing::MultiPairing single;
+    single.add(p, q);
+    EXPECT_EQ(single.evaluate(), ppT::reduced_pairing(p, q));
+
+    // e(a.g1, b.g2) * e(-ab.g1, g2) = 1, with the generator's line coefficients cached.
+    pairing::G2PrecomputeCache cache;
+    pairing::MultiPairing product;
+    product.add(p, q);
+    product.add(-((a * b) * G1::one()), G2::one(), cache);
+    EXPECT_TRUE(product.is_one());
+    product.add(G1::one(), G2::one(), cache);
+    EXPECT_FALSE(product.is_one());
+
+    // Points sharing a G2 point share a Miller loop, and terms that are one are dropped.
+    pairing::MultiPairing shared;
+    shared.add(p, q);
+    shared.add(-p, q);
+    shared.add(G1::zero(), G2::one());
+    shared.add(p, G2::zero());
+    EXPECT_EQ(shared.size(), 1UL);
+    EXPECT_TRUE(shared.is_one());
+
+    // A point is found in the cache whatever its projective coordinates.
+    EXPECT_EQ(cache.get(G2::one()), cache.get(G2::one()));
+    EXPECT_EQ(cache.get(G2::one().dbl()), cache.get(G2::one() + G2::one()));
+    EXPECT_NE(cache.get(G2::one()), cache.get(q));
+}
+
+namespace
+{
+
+// Writes buffer to path a piece at a time, pausing between pieces, and leaves off the last missing bytes.
+void write_slowly(std::string const &path, std::vector<char> const &buffer, size_t num_pieces, size_t missing = 0)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    const size_t size = buffer.size() - missing;
+    for (size_t i = 0; i < num_pieces; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const size_t start = i * size / num_pieces;
+        const size_t end = (i + 1) * size / num_pieces;
+        fwrite(&buffer[start], 1, end - start, file);
+        fflush(file);
+    }
+    fclose(file);
+}
+
+} // namespace
+
+TEST(streaming, follow_transcript)
+{
+    libff::init_alt_bn128_params();
+    std::vector<G1> g1_x(3000);
+    std::vector<G2> g2_x(20);
+    for (auto &point : g1_x)
+    {
+        point = G1::random_element();
+        point.to_affine_coordinates();
+    }
+    for (auto &point : g2_x)
+    {
+        point = G2::random_element();
+        point.to_affine_coordinates();
+    }
+    streaming::Manifest manifest;
+    manifest.transcript_number = 0;
+    manifest.total_transcripts = 1;
+    manifest.total_g1_points = g1_x.size();
+    manifest.total_g2_points = g2_x.size();
+    manifest.num_g1_points = g1_x.size();
+    manifest.num_g2_points = g2_x.size();
+    manifest.start_from = 0;
+    streaming::write_transcript(g1_x, g2_x, manifest, "/tmp/ft_test");
+    std::vector<char> buffer = streaming::read_file_into_buffer("/tmp/ft_test");
+
+    std::vector<G1> g1_result;
+    std::vector<G2> g2_result;
+    streaming::Manifest result_manifest;
+    size_t num_manifests = 0;
+    auto on_manifest = [&](streaming::Manifest const &m) {
+        // The manifest arrives before any points.
+        EXPECT_TRUE(g1_result.empty());
+        EXPECT_EQ(m.num_g1_points, g1_x.size());
+        ++num_manifests;
+    };
+    auto on_g1 = [&](char const *data, size_t size) { streaming::read_g1_elements_from_buffer(g1_result, data, size); };
+    auto on_g2 = [&](char const *data, size_t size) { streaming::read_g2_elements_from_buffer(g2_result, data, size); };
+
+    // A file that doesn't exist yet when the read starts, and grows a piece at a time.
+    remove("/tmp/ft_growing");
+    std::thread writer(write_slowly, "/tmp/ft_growing", buffer, 10, 0);
+    auto checksum = streaming::follow_transcript("/tmp/ft_growing", result_manifest, on_manifest, on_g1, on_g2, 5);
+    writer.join();
+    EXPECT_EQ(num_manifests, 1UL);
+    EXPECT_EQ(checksum, streaming::read_checksum("/tmp/ft_test"));
+    ASSERT_EQ(g1_result.size(), g1_x.size());
+    ASSERT_EQ(g2_result.size(), g2_x.size());
+    for (size_t i = 0; i < g1_x.size(); ++i)
+    {
+        EXPECT_EQ(g1_result[i], g1_x[i]);
+    }
+    for (size_t i = 0; i < g2_x.size(); ++i)
+    {
+        EXPECT_EQ(g2_result[i], g2_x[i]);
+    }
+
+    // A file that stops growing before it is complete.
+    g1_result.clear();
+    g2_result.clear();
+    remove("/tmp/ft_growing");
+    std::thread stalled(write_slowly, "/tmp/ft_growing", buffer, 3, 10);
+    EXPECT_THROW(streaming::follow_transcript("/tmp/ft_growing", result_manifest, on_manifest, on_g1, on_g2, 1), std::runtime_error);
+    stalled.join();
+
+    // A pipe whose writer closes it before the transcript is complete.
+    g1_result.clear();
+    g2_result.clear();
+    remove("/tmp/ft_fifo");
+    ASSERT_EQ(mkfifo("/tmp/ft_fifo", 0600), 0);
+    std::thread closed(write_slowly, "/tmp/ft_fifo", buffer, 3, 10);
+    EXPECT_THROW(streaming::follow_transcript("/tmp/ft_fifo", result_manifest, on_manifest, on_g1, on_g2, 5), std::runtime_error);
+    closed.join();
+}
@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
+
 #include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
 
+#include <aztec_common/fixed_base_bberg.hpp>
+#include <aztec_common/pippenger_bberg.hpp>
+#include <range/range_fft.hpp>
 #include <range/range_multi_exp.hpp>
 #include <generate_h/range_multi_exp.hpp>
 #include <generator/compute_generator_polynomial.hpp>
@@ -15,6 +20,27 @@
 
 namespace bb = barretenberg;
 
+namespace
+{
+
+// The powers of x from x^0 to x^num_points, as the points of a transcript hold them.
+std::vector<bb::g1::affine_element> compute_g1_x(bb::fr::field_t const &x, size_t num_points)
+{
+    std::vector<bb::g1::affine_element> g1_x;
+    g1_x.reserve(num_points + 1);
+    g1_x.emplace_back(bb::g1::affine_one());
+    bb::fr::field_t accumulator = x;
+    for (size_t i = 1; i < num_points + 1; ++i)
+    {
+        bb::g1::affine_element pt = bb::g1::affine_one();
+        g1_x.emplace_back(bb::g1::group_exponentiation(pt, accumulator));
+        accumulator = bb::fr::mul(x, accumulator);
+    }
+    return g1_x;
+}
+
+} // namespace
+
 /*
 TEST(range, window)
 {
@@ -60,18 +86,7 @@ TEST(range, process_range)
     std::vector<Fr> generator_polynomial = generator::compute_generator_polynomial<libff::alt_bn128_Fr>(kmax);
     auto bc = reinterpret_cast<bb::fr::field_t *>(&generator_polynomial[0]);
     auto x = bb::fr::random_element();
-    bb::fr::field_t accumulator = x;
-    std::vector<bb::g1::affine_element> g1_x;
-    g1_x.reserve(DEGREE + 1);
-
-    g1_x.emplace_back(bb::g1::affine_one());
-    for (size_t i = 1; i < DEGREE + 1; ++i)
-    {
-        bb::g1::affine_element pt = bb::g1::affine_one();
-        pt = bb::g1::group_exponentiation(pt, accumulator);
-        g1_x.emplace_back(pt);
-        accumulator = bb::fr::mul(x, accumulator);
-    }
+    std::vector<bb::g1::affine_element> g1_x = compute_g1_x(x, DEGREE);
 
     bb::g1::element h = generate_h::batch_process_range(DEGREE, 3, &g1_x[0], bc);
 
@@ -109,18 +124,7 @@ TEST(range, batch_process_range)
     std::vector<Fr> generator_polynomial = generator::compute_generator_polynomial<libff::alt_bn128_Fr>(kmax);
     auto bc = reinterpret_cast<bb::fr::field_t *>(&generator_polynomial[0]);
     auto x = bb::fr::random_element();
-    bb::fr::field_t accumulator = x;
-    std::vector<bb::g1::affine_element> g1_x;
-    g1_x.reserve(DEGREE + 1);
-
-    g1_x.emplace_back(bb::g1::affine_one());
-    for (size_t i = 1; i < DEGREE + 1; ++i)
-    {
-        bb::g1::affine_element pt = bb::g1::affine_one();
-        pt = bb::g1::group_exponentiation(pt, accumulator);
-        g1_x.emplace_back(pt);
-        accumulator = bb::fr::mul(x, accumulator);
-    }
+    std::vector<bb::g1::affine_element> g1_x = compute_g1_x(x, DEGREE);
 
     bb::g1::element h = generate_h::batch_process_range(DEGREE, 3, &g1_x[0], bc);
 
@@ -146,4 +150,211 @@ TEST(range, batch_process_range)
             EXPECT_EQ(result.y.data[i], h.y.data[i]);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(range, batch_process_range_with_shared_scratch)
+{
+    libff::init_alt_bn128_params();
+    constexpr size_t kmax = 0x101;
+    constexpr size_t DEGREE = kmax + 1;
+
+    std::vector<Fr> generator_polynomial = generator::compute_generator_polynomial<libff::alt_bn128_Fr>(kmax);
+    auto bc = reinterpret_cast<bb::fr::field_t *>(&generator_polynomial[0]);
+    auto x = bb::fr::random_element();
+    std::vector<bb::g1::affine_element> g1_x = compute_g1_x(x, DEGREE);
+
+    // Indices computed one after another with the same scratch give the same points as each on its own.
+    std::vector<bb::fr::field_t> scratch;
+    for (size_t i : {(size_t)5, (size_t)0, (size_t)1, DEGREE - 1, (size_t)5})
+    {
+        bb::g1::affine_element result, expected;
+        bb::g1::jacobian_to_affine(batch_process_range(i, DEGREE, 3, &g1_x[0], bc, scratch), result);
+        bb::g1::jacobian_to_affine(batch_process_range(i, DEGREE, 3, &g1_x[0], bc), expected);
+        for (size_t j = 0; j < 4; ++j)
+        {
+            EXPECT_EQ(result.x.data[j], expected.x.data[j]);
+            EXPECT_EQ(result.y.data[j], expected.y.data[j]);
+        }
+    }
+}
+
+TEST(range, batch_process_range_more_batches_than_points)
+{
+    libff::init_alt_bn128_params();
+    constexpr size_t kmax = 2;
+    constexpr size_t DEGREE = kmax + 1;
+    constexpr size_t BATCHES = 5;
+
+    std::vector<Fr> generator_polynomial = generator::compute_generator_polynomial<libff::alt_bn128_Fr>(kmax);
+    auto bc = reinterpret_cast<bb::fr::field_t *>(&generator_polynomial[0]);
+    auto x = bb::fr::random_element();
+    std::vector<bb::g1::affine_element> g1_x = compute_g1_x(x, DEGREE);
+
+    // Scratch left large by an earlier index, so that reading past an empty batch would go unnoticed.
+    std::vector<bb::fr::field_t> scratch(64, bb::fr::random_element());
+    for (size_t i = 1; i <= kmax; ++i)
+    {
+        // The serial recurrence, over every point at once.
+        bb::fr::field_t divisor;
+        bb::fr::to_montgomery_form({i, 0, 0, 0}, divisor);
+        bb::fr::neg(divisor, divisor);
+        divisor = bb::fr::invert(divisor);
+        std::vector<bb::fr::field_t> coefficients(DEGREE);
+        bb::fr::field_t previous = bb::fr::zero();
+        for (size_t j = 0; j < DEGREE; ++j)
+        {
+            previous = coefficients[j] = bb::fr::mul(bb::fr::sub(bc[j], previous), divisor);
+        }
+
+        bb::g1::affine_element result, expected;
+        bb::g1::jacobian_to_affine(pippenger::multi_exp_bberg(&g1_x[0], &coefficients[0], DEGREE, false), expected);
+        bb::g1::jacobian_to_affine(batch_process_range(i, DEGREE, BATCHES, &g1_x[0], bc, scratch), result);
+        for (size_t j = 0; j < 4; ++j)
+        {
+            EXPECT_EQ(result.x.data[j], expected.x.data[j]);
+            EXPECT_EQ(result.y.data[j], expected.y.data[j]);
+        }
+    }
+}
+
+TEST(range, blocked_synthetic_division)
+{
+    libff::init_alt_bn128_params();
+    // Enough points for the coefficients to be split into blocks on more than one thread.
+    constexpr size_t kmax = 2 * pippenger::MIN_POINTS_PER_THREAD;
+    constexpr size_t DEGREE = kmax + 1;
+
+    std::vector<Fr> generator_polynomial = generator::compute_generator_polynomial<libff::alt_bn128_Fr>(kmax);
+    auto bc = reinterpret_cast<bb::fr::field_t *>(&generator_polynomial[0]);
+    auto x = bb::fr::random_element();
+    std::vector<bb::g1::affine_element> g1_x = compute_g1_x(x, DEGREE);
+
+    bb::g1::affine_element h;
+    bb::g1::jacobian_to_affine(generate_h::batch_process_range(DEGREE, 1, &g1_x[0], bc), h);
+
+    // (x - k).point = h, with the coefficients carried across batches and across blocks within them.
+    for (size_t i : {(size_t)1, (size_t)7, kmax})
+    {
+        for (size_t batches : {(size_t)1, (size_t)2})
+        {
+            bb::g1::element process_result = batch_process_range(i, DEGREE, batches, &g1_x[0], bc);
+            bb::g1::element t0 = bb::g1::group_exponentiation(process_result, x);
+
+            bb::fr::field_t bbi;
+            bb::fr::to_montgomery_form({i, 0, 0, 0}, bbi);
+            bb::fr::neg(bbi, bbi);
+
+            bb::g1::element t1 = bb::g1::group_exponentiation(process_result, bbi);
+            bb::g1::element r;
+            bb::g1::add(t0, t1, r);
+
+            bb::g1::affine_element result;
+            bb::g1::jacobian_to_affine(r, result);
+            for (size_t j = 0; j < 4; ++j)
+            {
+                EXPECT_EQ(result.x.data[j], h.x.data[j]);
+                EXPECT_EQ(result.y.data[j], h.y.data[j]);
+            }
+        }
+    }
+}
+
+TEST(range, fixed_base_table)
+{
+    libff::init_alt_bn128_params();
+    // Enough points for the multi-exponentiations to be split across threads.
+    constexpr size_t kmax = 2 * pippenger::MIN_POINTS_PER_THREAD;
+    constexpr size_t DEGREE = kmax + 1;
+    constexpr size_t WINDOW_BITS = 8;
+
+    std::vector<Fr> generator_polynomial = generator::compute_generator_polynomial<libff::alt_bn128_Fr>(kmax);
+    auto bc = reinterpret_cast<bb::fr::field_t *>(&generator_polynomial[0]);
+    auto x = bb::fr::random_element();
+    std::vector<bb::g1::affine_element> g1_x = compute_g1_x(x, DEGREE);
+
+    // Written and mapped as prep_range_data and the tools do.
+    const std::string g1x_path = "/tmp/test_fixed_base_g1x.dat";
+    const std::string table_path = "/tmp/test_fixed_base_table.dat";
+    {
+        std::ofstream file(g1x_path, std::ios::binary);
+        file.write((char *)&g1_x[0], g1_x.size() * sizeof(bb::g1::affine_element));
+    }
+    fixed_base::write_table(g1x_path, g1_x.size(), WINDOW_BITS, table_path);
+    EXPECT_THROW(fixed_base::write_table(g1x_path, g1_x.size() + 1, WINDOW_BITS, table_path), std::runtime_error);
+    fixed_base::Table table = fixed_base::map_table(table_path);
+    EXPECT_EQ(table.window_bits, WINDOW_BITS);
+    EXPECT_EQ(table.num_points, g1_x.size());
+    fixed_base::check_table(table, &g1_x[0], g1_x.size());
+    EXPECT_THROW(fixed_base::check_table(table, &g1_x[1], g1_x.size() - 1), std::runtime_error);
+    EXPECT_THROW(fixed_base::check_table(table, &g1_x[0], g1_x.size() + 1), std::runtime_error);
+
+    auto expect_equal = [](bb::g1::element const &a, bb::g1::element const &b) {
+        bb::g1::affine_element a_affine;
+        bb::g1::affine_element b_affine;
+        bb::g1::jacobian_to_affine(a, a_affine);
+        bb::g1::jacobian_to_affine(b, b_affine);
+        for (size_t j = 0; j < 4; ++j)
+        {
+            EXPECT_EQ(a_affine.x.data[j], b_affine.x.data[j]);
+            EXPECT_EQ(a_affine.y.data[j], b_affine.y.data[j]);
+        }
+    };
+
+    // Both tools agree with their multi-exponentiations against the points themselves.
+    expect_equal(generate_h::batch_process_range(DEGREE, 2, &g1_x[0], bc, &table), generate_h::batch_process_range(DEGREE, 2, &g1_x[0], bc));
+    for (size_t i : {(size_t)0, (size_t)7, kmax})
+    {
+        std::vector<bb::fr::field_t> scratch;
+        expect_equal(batch_process_range(i, DEGREE, 2, &g1_x[0], bc, scratch, &table), batch_process_range(i, DEGREE, 2, &g1_x[0], bc));
+    }
+
+    // Random scalars exercise every digit, including the carries out of the top of each window.
+    std::vector<bb::fr::field_t> scalars(DEGREE);
+    for (auto &scalar : scalars)
+    {
+        scalar = bb::fr::random_element();
+    }
+    const bb::g1::element fixed_result = fixed_base::multi_exp(table, 1, &scalars[0], DEGREE);
+    expect_equal(fixed_result, pippenger::multi_exp_bberg(&g1_x[1], &scalars[0], DEGREE, false));
+    EXPECT_THROW(fixed_base::multi_exp(table, 2, &scalars[0], DEGREE), std::runtime_error);
+
+    remove(g1x_path.c_str());
+    remove(table_path.c_str());
+}
+
+TEST(range, compute_range_points)
+{
+    libff::init_alt_bn128_params();
+    constexpr size_t kmax = 0x101;
+    constexpr size_t DEGREE = kmax + 1;
+
+    std::vector<Fr> generator_polynomial = generator::compute_generator_polynomial<libff::alt_bn128_Fr>(kmax);
+    auto bc = reinterpret_cast<bb::fr::field_t *>(&generator_polynomial[0]);
+    auto x = bb::fr::random_element();
+    std::vector<bb::g1::affine_element> g1_x = compute_g1_x(x, DEGREE);
+
+    std::vector<libff::alt_bn128_G1> powers_of_x;
+    for (size_t i = 0; i < DEGREE; ++i)
+    {
+        libff::alt_bn128_Fq px, py;
+        memcpy(&px.mont_repr.data[0], &g1_x[i].x.data[0], sizeof(px.mont_repr.data));
+        memcpy(&py.mont_repr.data[0], &g1_x[i].y.data[0], sizeof(py.mont_repr.data));
+        powers_of_x.emplace_back(px, py, libff::alt_bn128_Fq::one());
+    }
+
+    // Every point at once matches each computed on its own. DEGREE is past range_fft::LEAF_POINTS, so this runs the
+    // FFTs and the evaluation tree.
+    std::vector<libff::alt_bn128_G1> points = range_fft::compute_range_points(generator_polynomial, &powers_of_x[0]);
+    ASSERT_EQ(points.size(), DEGREE);
+    for (size_t i = 0; i < DEGREE; ++i)
+    {
+        bb::g1::affine_element expected;
+        bb::g1::jacobian_to_affine(batch_process_range(i, DEGREE, 3, &g1_x[0], bc), expected);
+        points[i].to_affine_coordinates();
+        for (size_t j = 0; j < 4; ++j)
+        {
+            EXPECT_EQ(points[i].X.mont_repr.data[j], expected.x.data[j]);
+            EXPECT_EQ(points[i].Y.mont_repr.data[j], expected.y.data[j]);
+        }
+    }
+}
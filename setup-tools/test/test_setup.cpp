@@ -5,6 +5,9 @@
 #include <verify/verifier.hpp>
 #include <setup/setup.hpp>
 #include "test_utils.hpp"
+#include <sys/stat.h>
+#include <sstream>
+#include <thread>
 
 TEST(setup, batch_normalize_works)
 {
@@ -112,3 +115,495 @@ TEST(setup, validate_transcript)
     bool result = validate_transcript(g1_x[0], g2_x[0], g1_x, g2_x, {g1_x_prev[0]}, {g2_y});
     EXPECT_EQ(result, true);
 }
+
+TEST(setup, validate_polynomial_evaluation_rejects_broken_sequence)
+{
+    libff::init_alt_bn128_params();
+    size_t N = 100;
+    Fr y = Fr::random_element();
+    std::vector<G1> g1_x(N, G1::one());
+    std::atomic<size_t> progress(0);
+    compute_g1_thread(y, g1_x, 0, 0, N, progress);
+
+    std::vector<G2> g2_x;
+    Fr accumulator = y;
+    for (size_t i = 0; i < N; ++i)
+    {
+        g2_x.emplace_back(accumulator * G2::one());
+        accumulator = accumulator * y;
+    }
+    EXPECT_TRUE(validate_polynomial_evaluation(g2_x, g1_x[0]));
+
+    // The first, last and an inner point all contribute to the shared sum differently.
+    for (size_t broken : {(size_t)0, N / 2, N - 1})
+    {
+        std::vector<G1> broken_g1_x(g1_x);
+        broken_g1_x[broken] = broken_g1_x[broken].dbl();
+        EXPECT_FALSE(validate_polynomial_evaluation(broken_g1_x, y * G2::one()));
+
+        std::vector<G2> broken_g2_x(g2_x);
+        broken_g2_x[broken] = broken_g2_x[broken].dbl();
+        EXPECT_FALSE(validate_polynomial_evaluation(broken_g2_x, g1_x[0]));
+    }
+}
+
+TEST(setup, validate_polynomial_evaluation_with_small_exponents)
+{
+    libff::init_alt_bn128_params();
+    size_t N = 100;
+    Fr y = Fr::random_element();
+    std::vector<G1> g1_x(N, G1::one());
+    std::atomic<size_t> progress(0);
+    compute_g1_thread(y, g1_x, 0, 0, N, progress);
+    EXPECT_TRUE(validate_polynomial_evaluation(g1_x, y * G2::one(), true));
+
+    for (size_t broken : {(size_t)0, N / 2, N - 1})
+    {
+        std::vector<G1> broken_g1_x(g1_x);
+        broken_g1_x[broken] = broken_g1_x[broken].dbl();
+        EXPECT_FALSE(validate_polynomial_evaluation(broken_g1_x, y * G2::one(), true));
+    }
+}
+
+TEST(setup, same_ratio_accumulator_matches_across_windows)
+{
+    libff::init_alt_bn128_params();
+    size_t N = 100;
+    Fr y = Fr::random_element();
+    std::vector<G1> g1_x(N, G1::one());
+    std::atomic<size_t> progress(0);
+    compute_g1_thread(y, g1_x, 0, 0, N, progress);
+
+    VerificationKey<G2> delta;
+    delta.lhs = y * G2::one();
+    delta.rhs = G2::one();
+
+    std::vector<G1> broken_g1_x(g1_x);
+    broken_g1_x[N / 2] = broken_g1_x[N / 2].dbl();
+
+    for (bool small_exponents : {false, true})
+    {
+        // Windows that split the sequence evenly, unevenly, and one point at a time.
+        for (size_t window : {(size_t)1, (size_t)7, N / 2, N})
+        {
+            SameRatioAccumulator<G1> accumulator(small_exponents);
+            SameRatioAccumulator<G1> broken_accumulator(small_exponents);
+            for (size_t start = 0; start < N; start += window)
+            {
+                accumulator.add(&g1_x[start], std::min(window, N - start));
+                broken_accumulator.add(&broken_g1_x[start], std::min(window, N - start));
+            }
+            EXPECT_EQ(accumulator.size(), N);
+            EXPECT_TRUE(same_ratio(accumulator.key(), delta));
+            EXPECT_FALSE(same_ratio(broken_accumulator.key(), delta));
+        }
+    }
+}
+
+TEST(setup, verify_transcript_in_windows)
+{
+    libff::init_alt_bn128_params();
+    size_t N = 100;
+    Fr y = Fr::random_element();
+    std::vector<G1> g1_x(N, G1::one());
+    std::atomic<size_t> progress(0);
+    compute_g1_thread(y, g1_x, 0, 0, N, progress);
+
+    // Transcript 0 of a first participant, ending with g2^y.
+    std::vector<G2> g2_x;
+    Fr accumulator = y;
+    for (size_t i = 0; i < 2; ++i)
+    {
+        g2_x.emplace_back(accumulator * G2::one());
+        accumulator = accumulator * y;
+    }
+    g2_x.emplace_back(y * G2::one());
+
+    // Transcripts hold affine points.
+    for (auto &point : g1_x)
+    {
+        point.to_affine_coordinates();
+    }
+    for (auto &point : g2_x)
+    {
+        point.to_affine_coordinates();
+    }
+
+    streaming::Manifest manifest;
+    manifest.transcript_number = 0;
+    manifest.total_transcripts = 1;
+    manifest.total_g1_points = N;
+    manifest.total_g2_points = 2;
+    manifest.num_g1_points = N;
+    manifest.num_g2_points = 3;
+    manifest.start_from = 0;
+    streaming::write_transcript(g1_x, g2_x, manifest, "/tmp/vtw_test");
+
+    for (size_t window : {(size_t)1, (size_t)7, N, DEFAULT_WINDOW_POINTS})
+    {
+        EXPECT_NO_THROW(verify_transcript(manifest, "/tmp/vtw_test", "/tmp/vtw_test", "", window));
+        EXPECT_NO_THROW(verify_transcript(manifest, "/tmp/vtw_test", "/tmp/vtw_test", "", window, true));
+    }
+
+    g1_x[N - 1] = g1_x[N - 1].dbl();
+    g1_x[N - 1].to_affine_coordinates();
+    streaming::write_transcript(g1_x, g2_x, manifest, "/tmp/vtw_test");
+    EXPECT_THROW(verify_transcript(manifest, "/tmp/vtw_test", "/tmp/vtw_test", "", 7), std::runtime_error);
+    EXPECT_THROW(verify_transcript(manifest, "/tmp/vtw_test", "/tmp/vtw_test", "", 0), std::runtime_error);
+}
+
+namespace
+{
+
+// Writes the transcripts of a participant whose secret is x, with points_per_file points to a transcript.
+void write_participant_transcripts(std::string const &dir, Fr const &x, Fr const &y, size_t g1_n, size_t g2_n, size_t points_per_file)
+{
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    Fr accumulator = x;
+    for (size_t i = 0; i < std::max(g1_n, g2_n); ++i)
+    {
+        g1_x.emplace_back(accumulator * G1::one());
+        g2_x.emplace_back(accumulator * G2::one());
+        g1_x.back().to_affine_coordinates();
+        g2_x.back().to_affine_coordinates();
+        accumulator = accumulator * x;
+    }
+    G2 g2_y = y * G2::one();
+    g2_y.to_affine_coordinates();
+
+    mkdir(dir.c_str(), 0755);
+    const size_t num_transcripts = (std::max(g1_n, g2_n) + points_per_file - 1) / points_per_file;
+    for (size_t i = 0; i < num_transcripts; ++i)
+    {
+        streaming::Manifest manifest;
+        manifest.transcript_number = i;
+        manifest.total_transcripts = num_transcripts;
+        manifest.total_g1_points = g1_n;
+        manifest.total_g2_points = g2_n;
+        manifest.start_from = i * points_per_file;
+        manifest.num_g1_points = std::min(points_per_file, g1_n > manifest.start_from ? g1_n - manifest.start_from : 0);
+        manifest.num_g2_points = std::min(points_per_file, g2_n > manifest.start_from ? g2_n - manifest.start_from : 0);
+        std::vector<G1> g1(g1_x.begin() + manifest.start_from, g1_x.begin() + manifest.start_from + manifest.num_g1_points);
+        std::vector<G2> g2(g2_x.begin() + manifest.start_from, g2_x.begin() + manifest.start_from + manifest.num_g2_points);
+        if (i == 0)
+        {
+            manifest.num_g2_points += 1;
+            g2.push_back(g2_y);
+        }
+        streaming::write_transcript(g1, g2, manifest, streaming::getTranscriptInPath(dir, i));
+    }
+    remove(streaming::getTranscriptInPath(dir, num_transcripts).c_str());
+}
+
+} // namespace
+
+TEST(setup, verify_transcripts_as_a_whole)
+{
+    libff::init_alt_bn128_params();
+    const std::string previous_dir = "/tmp/vta_previous_test";
+    const std::string dir = "/tmp/vta_test";
+    Fr previous_x = Fr::random_element();
+    Fr y = Fr::random_element();
+    write_participant_transcripts(previous_dir, previous_x, previous_x, 30, 12, 10);
+    write_participant_transcripts(dir, previous_x * y, y, 30, 12, 10);
+    const std::string previous_transcript0 = streaming::getTranscriptInPath(previous_dir, 0);
+
+    auto set = streaming::find_transcripts(dir);
+    EXPECT_EQ(set.size(), 3UL);
+    for (size_t window : {(size_t)1, (size_t)4, DEFAULT_WINDOW_POINTS})
+    {
+        EXPECT_NO_THROW(verify_transcripts(set, "", window));
+        EXPECT_NO_THROW(verify_transcripts(set, previous_transcript0, window));
+        EXPECT_NO_THROW(verify_transcripts(set, previous_transcript0, window, true));
+    }
+
+    // Built on a different previous participant.
+    write_participant_transcripts(previous_dir, Fr::random_element(), y, 30, 12, 10);
+    EXPECT_THROW(verify_transcripts(set, previous_transcript0, 4), std::runtime_error);
+
+    // A transcript that doesn't continue on from the one before, though its own sequence is consistent.
+    streaming::Manifest manifest;
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    streaming::read_transcript(g1_x, g2_x, manifest, set.paths[1]);
+    for (auto &point : g1_x)
+    {
+        point = point.dbl();
+        point.to_affine_coordinates();
+    }
+    streaming::write_transcript(g1_x, g2_x, manifest, set.paths[1]);
+    EXPECT_THROW(verify_transcripts(set, "", 4), std::runtime_error);
+    EXPECT_THROW(verify_transcripts(set, "", 4, true), std::runtime_error);
+}
+
+TEST(setup, verify_transcript_with_shared_cache)
+{
+    libff::init_alt_bn128_params();
+    const std::string dir = "/tmp/vtc_test";
+    write_participant_transcripts(dir, Fr::random_element(), Fr::random_element(), 30, 12, 10);
+    auto set = streaming::find_transcripts(dir);
+
+    // Each transcript is verified twice, the second time with its neighbours' points already cached.
+    VerifierCache cache;
+    for (size_t round = 0; round < 2; ++round)
+    {
+        for (size_t i = 0; i < set.size(); ++i)
+        {
+            streaming::Manifest manifest = set.manifests[i];
+            EXPECT_NO_THROW(verify_transcript(cache, manifest, set.paths[i], set.paths[0], i ? set.paths[i - 1] : "", 4));
+        }
+    }
+
+    // A previous transcript whose last points don't lead on to the next.
+    const std::string broken_path = "/tmp/vtc_test/broken.dat";
+    streaming::Manifest manifest;
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    streaming::read_transcript(g1_x, g2_x, manifest, set.paths[1]);
+    g1_x.back() = g1_x.back().dbl();
+    g1_x.back().to_affine_coordinates();
+    streaming::write_transcript(g1_x, g2_x, manifest, broken_path);
+    manifest = set.manifests[2];
+    EXPECT_THROW(verify_transcript(cache, manifest, set.paths[2], set.paths[0], broken_path, 4), std::runtime_error);
+}
+
+TEST(setup, verify_growing_transcript)
+{
+    libff::init_alt_bn128_params();
+    const std::string dir = "/tmp/vgt_test";
+    write_participant_transcripts(dir, Fr::random_element(), Fr::random_element(), 30, 12, 10);
+    auto set = streaming::find_transcripts(dir);
+    auto accept = [](streaming::Manifest const &) {};
+
+    // Each transcript is copied in after the verification has started, while it waits for the file to appear.
+    for (size_t i = 0; i < 2; ++i)
+    {
+        const std::string growing_path = "/tmp/vgt_growing_" + std::to_string(i) + ".dat";
+        remove(growing_path.c_str());
+        std::vector<char> buffer = streaming::read_file_into_buffer(set.paths[i]);
+        std::thread writer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            streaming::write_buffer_to_file(growing_path, buffer);
+        });
+        VerifierCache cache;
+        streaming::Manifest manifest;
+        EXPECT_NO_THROW(verify_growing_transcript(cache, manifest, growing_path, i ? set.paths[0] : growing_path, i ? set.paths[0] : "", accept, 4));
+        writer.join();
+        EXPECT_EQ(manifest.transcript_number, i);
+    }
+
+    // A manifest that is rejected stops the verification before any points are read.
+    VerifierCache cache;
+    streaming::Manifest manifest;
+    auto reject = [](streaming::Manifest const &) { throw std::runtime_error("Unexpected transcript number."); };
+    EXPECT_THROW(verify_growing_transcript(cache, manifest, set.paths[1], set.paths[0], set.paths[0], reject, 4), std::runtime_error);
+}
+
+TEST(setup, verify_transcript_staged)
+{
+    libff::init_alt_bn128_params();
+    const std::string previous_dir = "/tmp/vts_previous_test";
+    const std::string dir = "/tmp/vts_test";
+    Fr previous_x = Fr::random_element();
+    Fr y = Fr::random_element();
+    write_participant_transcripts(previous_dir, previous_x, previous_x, 30, 12, 10);
+    write_participant_transcripts(dir, previous_x * y, y, 30, 12, 10);
+    const std::string previous_transcript0 = streaming::getTranscriptInPath(previous_dir, 0);
+    auto set = streaming::find_transcripts(dir);
+
+    for (size_t prefix : {(size_t)1, (size_t)4, DEFAULT_PREFIX_POINTS})
+    {
+        for (size_t i = 0; i < set.size(); ++i)
+        {
+            streaming::Manifest manifest = set.manifests[i];
+            EXPECT_NO_THROW(verify_transcript(manifest, set.paths[i], set.paths[0], i ? set.paths[i - 1] : previous_transcript0, 4, false, prefix));
+        }
+    }
+
+    // A broken point past the prefix passes the early checks, and fails the full verification.
+    const std::string broken_path = "/tmp/vts_test/broken.dat";
+    streaming::Manifest manifest;
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    streaming::read_transcript(g1_x, g2_x, manifest, set.paths[1]);
+    g1_x.back() = g1_x.back().dbl();
+    g1_x.back().to_affine_coordinates();
+    streaming::write_transcript(g1_x, g2_x, manifest, broken_path);
+    testing::internal::CaptureStdout();
+    EXPECT_THROW(verify_transcript(manifest, broken_path, set.paths[0], set.paths[0], 4, false, 4), std::runtime_error);
+    EXPECT_NE(testing::internal::GetCapturedStdout().find("Early checks passed."), std::string::npos);
+
+    // A broken point within the prefix is rejected by the early checks.
+    g1_x.front() = g1_x.front().dbl();
+    g1_x.front().to_affine_coordinates();
+    streaming::write_transcript(g1_x, g2_x, manifest, broken_path);
+    testing::internal::CaptureStdout();
+    EXPECT_THROW(verify_transcript(manifest, broken_path, set.paths[0], set.paths[0], 4, false, 4), std::runtime_error);
+    EXPECT_EQ(testing::internal::GetCapturedStdout().find("Early checks passed."), std::string::npos);
+
+    // Built on a different previous participant.
+    write_participant_transcripts(previous_dir, Fr::random_element(), y, 30, 12, 10);
+    manifest = set.manifests[0];
+    testing::internal::CaptureStdout();
+    EXPECT_THROW(verify_transcript(manifest, set.paths[0], set.paths[0], previous_transcript0, 4, false, 4), std::runtime_error);
+    EXPECT_EQ(testing::internal::GetCapturedStdout().find("Early checks passed."), std::string::npos);
+}
+
+TEST(setup, verify_recorded_transcript)
+{
+    libff::init_alt_bn128_params();
+    const std::string dir = "/tmp/vrt_test";
+    const std::string ledger_path = "/tmp/vrt_ledger.dat";
+    remove(ledger_path.c_str());
+    write_participant_transcripts(dir, Fr::random_element(), Fr::random_element(), 30, 12, 10);
+    auto set = streaming::find_transcripts(dir);
+
+    // Verified once, then answered from the ledger.
+    {
+        streaming::TranscriptLedger ledger(ledger_path);
+        streaming::Manifest manifest = set.manifests[1];
+        EXPECT_FALSE(verify_recorded_transcript(ledger, manifest, set.paths[1], set.paths[0], set.paths[0], 4));
+        EXPECT_TRUE(verify_recorded_transcript(ledger, manifest, set.paths[1], set.paths[0], set.paths[0], 4));
+        EXPECT_EQ(ledger.size(), 1UL);
+    }
+
+    // A transcript that can't be read is not recorded, so it is checked again once it can be.
+    const std::string truncated_path = "/tmp/vrt_test/truncated.dat";
+    std::vector<char> buffer = streaming::read_file_into_buffer(set.paths[2]);
+    buffer.resize(buffer.size() / 2);
+    streaming::write_buffer_to_file(truncated_path, buffer);
+    {
+        streaming::TranscriptLedger ledger(ledger_path);
+        streaming::Manifest manifest = set.manifests[2];
+        bool verification_failure = false;
+        try
+        {
+            verify_recorded_transcript(ledger, manifest, truncated_path, set.paths[0], set.paths[1], 4);
+            ADD_FAILURE() << "Truncated transcript verified.";
+        }
+        catch (VerificationFailure const &)
+        {
+            verification_failure = true;
+        }
+        catch (std::exception const &)
+        {
+        }
+        EXPECT_FALSE(verification_failure);
+    }
+    EXPECT_EQ(streaming::TranscriptLedger(ledger_path).size(), 1UL);
+
+    // A transcript found invalid is recorded as such.
+    const std::string broken_path = "/tmp/vrt_test/broken.dat";
+    streaming::Manifest manifest;
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    streaming::read_transcript(g1_x, g2_x, manifest, set.paths[2]);
+    g1_x.back() = g1_x.back().dbl();
+    g1_x.back().to_affine_coordinates();
+    streaming::write_transcript(g1_x, g2_x, manifest, broken_path);
+    {
+        streaming::TranscriptLedger ledger(ledger_path);
+        EXPECT_THROW(verify_recorded_transcript(ledger, manifest, broken_path, set.paths[0], set.paths[1], 4), VerificationFailure);
+        EXPECT_EQ(ledger.size(), 2UL);
+        EXPECT_THROW(verify_recorded_transcript(ledger, manifest, broken_path, set.paths[0], set.paths[1], 4), VerificationFailure);
+    }
+}
+
+TEST(setup, verify_chain)
+{
+    libff::init_alt_bn128_params();
+    std::vector<std::string> dirs = {"/tmp/vch_test_0", "/tmp/vch_test_1", "/tmp/vch_test_2"};
+    std::vector<Fr> y = {Fr::random_element(), Fr::random_element(), Fr::random_element()};
+    Fr x = Fr::one();
+    for (size_t p = 0; p < dirs.size(); ++p)
+    {
+        x = x * y[p];
+        write_participant_transcripts(dirs[p], x, y[p], 30, 12, 10);
+    }
+
+    std::vector<streaming::TranscriptSet> sets;
+    for (auto const &dir : dirs)
+    {
+        sets.push_back(streaming::find_transcripts(dir));
+    }
+    for (size_t window : {(size_t)4, DEFAULT_WINDOW_POINTS})
+    {
+        EXPECT_NO_THROW(verify_chain(sets, "", window));
+        EXPECT_NO_THROW(verify_chain(sets, "", window, true));
+    }
+    EXPECT_NO_THROW(verify_chain({sets[1], sets[2]}, sets[0].paths[0], 4));
+
+    // The last participant built on a participant other than the one before it.
+    write_participant_transcripts(dirs[2], Fr::random_element(), y[2], 30, 12, 10);
+    try
+    {
+        verify_chain(sets, "", 4);
+        FAIL() << "Expected the chain to be rejected.";
+    }
+    catch (std::runtime_error const &err)
+    {
+        EXPECT_EQ(std::string(err.what()), "Participant 2: Transcript was not derived from previous participants.");
+    }
+    EXPECT_NO_THROW(verify_chain({sets[0], sets[1]}, "", 4));
+}
+
+TEST(setup, verify_partial_and_combine)
+{
+    libff::init_alt_bn128_params();
+    const std::string previous_dir = "/tmp/vpc_previous_test";
+    const std::string dir = "/tmp/vpc_test";
+    Fr previous_x = Fr::random_element();
+    Fr y = Fr::random_element();
+    write_participant_transcripts(previous_dir, previous_x, previous_x, 30, 12, 10);
+    write_participant_transcripts(dir, previous_x * y, y, 30, 12, 10);
+    const std::string previous_transcript0 = streaming::getTranscriptInPath(previous_dir, 0);
+    auto set = streaming::find_transcripts(dir);
+    std::vector<unsigned char> seed(32, 7);
+
+    // Each transcript's points are split into ranges of 3, which pass through their text form.
+    auto partials_of = [&](std::string const &path, std::vector<unsigned char> const &range_seed, bool small_exponents) {
+        std::vector<TranscriptPartial> partials;
+        for (size_t first = 0; first < 10; first += 3)
+        {
+            std::ostringstream os;
+            write_partial(os, verify_partial(path, range_seed, first, 3, 2, small_exponents));
+            partials.push_back(read_partial(os.str()));
+        }
+        return partials;
+    };
+    for (bool small_exponents : {false, true})
+    {
+        for (size_t i = 0; i < set.size(); ++i)
+        {
+            streaming::Manifest manifest;
+            auto partials = partials_of(set.paths[i], seed, small_exponents);
+            std::string const previous = i ? set.paths[i - 1] : previous_transcript0;
+            EXPECT_NO_THROW(verify_combine(manifest, set.paths[i], set.paths[0], previous, seed, partials, small_exponents));
+            EXPECT_EQ(manifest.transcript_number, i);
+
+            // Ranges missing, or computed with another seed.
+            auto missing = partials;
+            missing.erase(missing.begin() + 1);
+            EXPECT_THROW(verify_combine(manifest, set.paths[i], set.paths[0], previous, seed, missing, small_exponents), std::runtime_error);
+            auto doubled = partials;
+            doubled.push_back(partials[0]);
+            EXPECT_THROW(verify_combine(manifest, set.paths[i], set.paths[0], previous, seed, doubled, small_exponents), std::runtime_error);
+            std::vector<unsigned char> other_seed(32, 8);
+            auto mixed = partials_of(set.paths[i], other_seed, small_exponents);
+            mixed[0] = partials[0];
+            EXPECT_THROW(verify_combine(manifest, set.paths[i], set.paths[0], previous, seed, mixed, small_exponents), std::runtime_error);
+        }
+    }
+
+    // A broken point in one range.
+    const std::string broken_path = "/tmp/vpc_test/broken.dat";
+    streaming::Manifest manifest;
+    std::vector<G1> g1_x;
+    std::vector<G2> g2_x;
+    streaming::read_transcript(g1_x, g2_x, manifest, set.paths[1]);
+    g1_x[4] = g1_x[4].dbl();
+    g1_x[4].to_affine_coordinates();
+    streaming::write_transcript(g1_x, g2_x, manifest, broken_path);
+    EXPECT_THROW(verify_combine(manifest, broken_path, set.paths[0], set.paths[0], seed, partials_of(broken_path, seed, false)), std::runtime_error);
+}